@@ -0,0 +1,125 @@
+#include "Baseline.h"
+
+#include "Core/Log.h"
+
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <iostream>
+#include <iomanip>
+
+namespace clear {
+
+	static double GetCounter(const benchmark::BenchmarkReporter::Run& run, const char* name)
+	{
+		auto it = run.counters.find(name);
+		return it != run.counters.end() ? double(it->second) : 0.0;
+	}
+
+	void BaselineReporter::ReportRuns(const std::vector<Run>& reports)
+	{
+		ConsoleReporter::ReportRuns(reports);
+
+		for (const Run& run : reports)
+		{
+			if (run.error_occurred)
+				continue;
+
+			const bool median = run.run_type == Run::RT_Aggregate && run.aggregate_name == "median";
+
+			if (run.run_type == Run::RT_Aggregate && !median)
+				continue;
+
+			const std::string name = run.run_name.str();
+
+			// the iterations of a repeated benchmark are reported before its aggregates
+			if (!median && m_Results.contains(name))
+				continue;
+
+			m_Results[name] = { .BytesPerSecond = GetCounter(run, "bytes_per_second"), .LinesPerSecond = GetCounter(run, "lines_per_second") };
+		}
+	}
+
+	void SaveBaseline(const Baseline& baseline, const std::filesystem::path& path)
+	{
+		llvm::json::Object root;
+
+		for (const auto& [name, entry] : baseline)
+			root[name] = llvm::json::Object{ { "bytes_per_second", entry.BytesPerSecond }, { "lines_per_second", entry.LinesPerSecond } };
+
+		std::error_code error;
+		llvm::raw_fd_ostream stream(path.string(), error);
+		CLEAR_VERIFY(!error, "failed to write baseline ", path.string(), ": ", error.message());
+
+		stream << llvm::formatv("{0:2}", llvm::json::Value(std::move(root))) << "\n";
+	}
+
+	Baseline LoadBaseline(const std::filesystem::path& path)
+	{
+		auto buffer = llvm::MemoryBuffer::getFile(path.string());
+		CLEAR_VERIFY(buffer, "failed to read baseline ", path.string(), ": ", buffer.getError().message());
+
+		auto json = llvm::json::parse((*buffer)->getBuffer());
+		CLEAR_VERIFY(json, "invalid baseline ", path.string(), ": ", llvm::toString(json.takeError()));
+
+		const llvm::json::Object* root = json->getAsObject();
+		CLEAR_VERIFY(root, "baseline ", path.string(), " is not a json object");
+
+		Baseline baseline;
+
+		for (const auto& [name, value] : *root)
+		{
+			const llvm::json::Object* entry = value.getAsObject();
+
+			if (!entry)
+				continue;
+
+			baseline[name.str()] = { .BytesPerSecond = entry->getNumber("bytes_per_second").value_or(0.0),
+									 .LinesPerSecond = entry->getNumber("lines_per_second").value_or(0.0) };
+		}
+
+		return baseline;
+	}
+
+	bool CompareBaseline(const Baseline& baseline, const Baseline& current, double threshold)
+	{
+		bool passed = true;
+
+		std::cout << "------BASELINE COMPARISON--------" << std::endl;
+		std::cout << std::left << std::setw(40) << "Benchmark" << std::right << std::setw(16) << "Baseline MB/s"
+				  << std::setw(16) << "Current MB/s" << std::setw(10) << "Change" << std::endl;
+
+		std::cout << std::fixed << std::setprecision(2);
+
+		for (const auto& [name, entry] : current)
+		{
+			auto it = baseline.find(name);
+
+			if (it == baseline.end() || it->second.BytesPerSecond <= 0.0)
+			{
+				std::cout << std::left << std::setw(40) << name << std::right << std::setw(16) << "-"
+						  << std::setw(16) << entry.BytesPerSecond / 1e6 << std::setw(10) << "new" << std::endl;
+				continue;
+			}
+
+			const double change = entry.BytesPerSecond / it->second.BytesPerSecond - 1.0;
+			const bool regressed = change < -threshold;
+
+			std::cout << std::left << std::setw(40) << name << std::right << std::setw(16) << it->second.BytesPerSecond / 1e6
+					  << std::setw(16) << entry.BytesPerSecond / 1e6 << std::setw(9) << change * 100.0 << "%"
+					  << (regressed ? "  REGRESSION" : "") << std::endl;
+
+			passed &= !regressed;
+		}
+
+		std::cout << std::defaultfloat;
+
+		if (!passed)
+			CLEAR_LOG_ERROR("throughput regressed by more than ", threshold * 100.0, "% against the baseline");
+
+		return passed;
+	}
+
+}
\ No newline at end of file
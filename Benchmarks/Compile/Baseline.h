@@ -0,0 +1,40 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <string>
+#include <filesystem>
+
+namespace clear {
+
+	// throughput of a single benchmark, both are per second
+	struct BaselineEntry
+	{
+		double BytesPerSecond = 0.0;
+		double LinesPerSecond = 0.0;
+	};
+
+	using Baseline = std::map<std::string, BaselineEntry>;
+
+	// prints to the console like the default reporter but also keeps the throughput of every run,
+	// the median is preferred when benchmarks are repeated
+	class BaselineReporter : public benchmark::ConsoleReporter
+	{
+	public:
+		void ReportRuns(const std::vector<Run>& reports) override;
+
+		const Baseline& GetResults() const { return m_Results; }
+
+	private:
+		Baseline m_Results;
+	};
+
+	extern void SaveBaseline(const Baseline& baseline, const std::filesystem::path& path);
+	extern Baseline LoadBaseline(const std::filesystem::path& path);
+
+	// prints how every benchmark compares against the baseline, returns false if any of them
+	// lost more than threshold (e.g 0.1 for 10%) of its throughput
+	extern bool CompareBaseline(const Baseline& baseline, const Baseline& current, double threshold);
+
+}
\ No newline at end of file
@@ -0,0 +1,437 @@
+#include "CorpusGenerator.h"
+#include "Baseline.h"
+
+#include "Parsing/Parser.h"
+#include "Parsing/TokenStream.h"
+#include "AST/AST.h"
+#include "AST/FlatAST.h"
+#include "API/LLVM/LLVMBackend.h"
+#include "Core/Log.h"
+#include "Core/Scan.h"
+#include "Core/CompileCache.h"
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <string>
+#include <cstring>
+#include <memory>
+#include <filesystem>
+
+using namespace clear;
+
+static std::filesystem::path s_CorpusDirectory = std::filesystem::temp_directory_path() / "clear_bench";
+
+// corpora are generated once per size and shared between the phases
+static const Corpus& GetCorpus(size_t functions)
+{
+    static std::map<size_t, Corpus> s_Corpora;
+
+    auto it = s_Corpora.find(functions);
+
+    if (it != s_Corpora.end())
+        return it->second;
+
+    CorpusOptions options;
+    options.Functions = functions;
+    options.Structs = functions / 10;
+
+    return s_Corpora[functions] = WriteCorpus(options, s_CorpusDirectory, "corpus_" + std::to_string(functions));
+}
+
+// mostly comments and strings, like generated bindings and tables. lexer only, strings don't reach codegen yet
+static const Corpus& GetDocumentedCorpus(size_t functions)
+{
+    static std::map<size_t, Corpus> s_Corpora;
+
+    auto it = s_Corpora.find(functions);
+
+    if (it != s_Corpora.end())
+        return it->second;
+
+    CorpusOptions options;
+    options.Functions = functions;
+    options.Structs = functions / 10;
+    options.DocumentationLines = 8;
+    options.StringTable = functions * 4;
+
+    return s_Corpora[functions] = WriteCorpus(options, s_CorpusDirectory, "documented_" + std::to_string(functions));
+}
+
+static void SetThroughput(benchmark::State& state, const Corpus& corpus)
+{
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(corpus.Source.size()));
+    state.counters["lines_per_second"] = benchmark::Counter(double(corpus.Lines), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static void BM_Lexer(benchmark::State& state)
+{
+    const Corpus& corpus = GetCorpus(size_t(state.range(0)));
+
+    for (auto _ : state)
+    {
+        Parser parser;
+        ProgramInfo info = parser.CreateTokensFromFile(corpus.Path);
+        benchmark::DoNotOptimize(info.Tokens.data());
+    }
+
+    SetThroughput(state, corpus);
+}
+
+// compares the scalar scanner against the best one the cpu supports
+static void BM_LexerScan(benchmark::State& state)
+{
+    const Corpus& corpus = GetDocumentedCorpus(size_t(state.range(0)));
+
+    const ScanLevel previous = GetScanLevel();
+    SetScanLevel(ScanLevel(state.range(1)));
+
+    for (auto _ : state)
+    {
+        Parser parser;
+        ProgramInfo info = parser.CreateTokensFromFile(corpus.Path);
+        benchmark::DoNotOptimize(info.Tokens.data());
+    }
+
+    state.SetLabel(ScanLevelToString(GetScanLevel()));
+    SetScanLevel(previous);
+
+    SetThroughput(state, corpus);
+}
+
+// the same file split into chunks that are lexed on several threads
+static void BM_LexerParallel(benchmark::State& state)
+{
+    const Corpus& corpus = GetCorpus(size_t(state.range(0)));
+
+    for (auto _ : state)
+    {
+        Parser parser;
+        ProgramInfo info = parser.CreateTokensFromFile(corpus.Path, uint32_t(state.range(1)));
+        benchmark::DoNotOptimize(info.Tokens.data());
+    }
+
+    SetThroughput(state, corpus);
+}
+
+static void BM_AST(benchmark::State& state)
+{
+    const Corpus& corpus = GetCorpus(size_t(state.range(0)));
+
+    Parser parser;
+    ProgramInfo info = parser.CreateTokensFromFile(corpus.Path);
+
+    LLVM::Backend::Init();
+
+    size_t memory = 0;
+
+    for (auto _ : state)
+    {
+        AST ast(info);
+        memory = ast.GetMemoryUsage();
+        benchmark::ClobberMemory();
+    }
+
+    LLVM::Backend::Shutdown();
+
+    SetThroughput(state, corpus);
+    state.counters["ast_bytes_per_line"] = double(memory) / double(corpus.Lines);
+}
+
+static void BM_FlatAST(benchmark::State& state)
+{
+    const Corpus& corpus = GetCorpus(size_t(state.range(0)));
+
+    Parser parser;
+    ProgramInfo info = parser.CreateTokensFromFile(corpus.Path);
+
+    LLVM::Backend::Init();
+
+    size_t memory = 0;
+    size_t nodes = 0;
+
+    for (auto _ : state)
+    {
+        FlatAST ast(info);
+        memory = ast.GetMemoryUsage();
+        nodes = ast.GetNodeCount();
+        benchmark::ClobberMemory();
+    }
+
+    LLVM::Backend::Shutdown();
+
+    SetThroughput(state, corpus);
+    state.counters["ast_bytes_per_line"] = double(memory) / double(corpus.Lines);
+    state.counters["nodes"] = double(nodes);
+}
+
+// lexing and building the ast one after the other (0) against streaming the tokens between two threads (1)
+static void BM_LexerAST(benchmark::State& state)
+{
+    const Corpus& corpus = GetCorpus(size_t(state.range(0)));
+    const bool streamed = state.range(1) != 0;
+
+    LLVM::Backend::Init();
+
+    for (auto _ : state)
+    {
+        if (streamed)
+        {
+            TokenStream stream(corpus.Path);
+            AST ast(stream);
+            benchmark::ClobberMemory();
+        }
+        else
+        {
+            Parser parser;
+            ProgramInfo info = parser.CreateTokensFromFile(corpus.Path);
+            AST ast(info);
+            benchmark::ClobberMemory();
+        }
+    }
+
+    LLVM::Backend::Shutdown();
+
+    state.SetLabel(streamed ? "streamed" : "serial");
+    SetThroughput(state, corpus);
+}
+
+// a line is added to and removed from the middle of the file, only the tokens and nodes around it are rebuilt
+static void BM_IncrementalEdit(benchmark::State& state)
+{
+    const Corpus& corpus = GetCorpus(size_t(state.range(0)));
+
+    Parser parser;
+    parser.SetIncremental(true);
+
+    ProgramInfo info = parser.CreateTokensFromFile(corpus.Path);
+
+    const std::string line = "// edit\n";
+    const size_t middle = corpus.Source.find('\n', corpus.Source.size() / 2) + 1;
+
+    LLVM::Backend::Init();
+
+    auto ast = std::make_unique<AST>(info);
+    bool inserted = false;
+
+    for (auto _ : state)
+    {
+        TextEdit edit;
+        edit.Start = middle;
+        edit.End = inserted ? middle + line.size() : middle;
+        edit.Text = inserted ? "" : line;
+
+        TokenEdit tokenEdit = parser.UpdateTokens(info, edit);
+        ast = std::make_unique<AST>(info, *ast, tokenEdit);
+
+        inserted = !inserted;
+        benchmark::ClobberMemory();
+    }
+
+    ast.reset();
+    LLVM::Backend::Shutdown();
+}
+
+// lexing and building the ast (0) against reading both back from a cache entry (1)
+static void BM_CompileCache(benchmark::State& state)
+{
+    const Corpus& corpus = GetCorpus(size_t(state.range(0)));
+    const bool cached = state.range(1) != 0;
+
+    CompileCache cache(s_CorpusDirectory / "cache", uint64_t(1) << 30);
+    const uint64_t key = CompileCache::GetKey(corpus.Source, "main");
+
+    std::shared_ptr<llvm::MemoryBuffer> source = llvm::MemoryBuffer::getMemBuffer(corpus.Source, corpus.Path.string(), false);
+
+    LLVM::Backend::Init();
+
+    if (cached && !cache.Load(key))
+    {
+        Parser parser;
+        ProgramInfo info = parser.CreateTokensFromFile(corpus.Path);
+        AST ast(info);
+
+        std::string data;
+        BinaryWriter writer(data);
+
+        info.Serialize(writer);
+        ast.Serialize(writer);
+
+        cache.Store(key, data);
+    }
+
+    for (auto _ : state)
+    {
+        if (cached)
+        {
+            auto entry = cache.Load(key);
+            BinaryReader reader(CompileCache::GetData(*entry));
+
+            ProgramInfo info = ProgramInfo::Deserialize(reader, source);
+            AST ast(reader);
+            benchmark::ClobberMemory();
+        }
+        else
+        {
+            Parser parser;
+            ProgramInfo info = parser.CreateTokensFromFile(corpus.Path);
+            AST ast(info);
+            benchmark::ClobberMemory();
+        }
+    }
+
+    LLVM::Backend::Shutdown();
+
+    state.SetLabel(cached ? "cached" : "built");
+    SetThroughput(state, corpus);
+}
+
+static void BM_Codegen(benchmark::State& state)
+{
+    const Corpus& corpus = GetCorpus(size_t(state.range(0)));
+
+    Parser parser;
+    ProgramInfo info = parser.CreateTokensFromFile(corpus.Path);
+
+    for (auto _ : state)
+    {
+        // every iteration needs a fresh module, otherwise functions are redefined
+        state.PauseTiming();
+        LLVM::Backend::Init();
+        AST ast(info);
+        state.ResumeTiming();
+
+        ast.BuildIR();
+
+        state.PauseTiming();
+        LLVM::Backend::Shutdown();
+        state.ResumeTiming();
+    }
+
+    SetThroughput(state, corpus);
+}
+
+static void BM_FlatCodegen(benchmark::State& state)
+{
+    const Corpus& corpus = GetCorpus(size_t(state.range(0)));
+
+    Parser parser;
+    ProgramInfo info = parser.CreateTokensFromFile(corpus.Path);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        LLVM::Backend::Init();
+        FlatAST ast(info);
+        state.ResumeTiming();
+
+        ast.BuildIR();
+
+        state.PauseTiming();
+        LLVM::Backend::Shutdown();
+        state.ResumeTiming();
+    }
+
+    SetThroughput(state, corpus);
+}
+
+static void BM_Emit(benchmark::State& state)
+{
+    const Corpus& corpus = GetCorpus(size_t(state.range(0)));
+
+    Parser parser;
+    ProgramInfo info = parser.CreateTokensFromFile(corpus.Path);
+
+    LLVM::BuildOptions options;
+    options.OptLevel = LLVM::OptimizationLevel(state.range(1));
+    options.OutputPath = s_CorpusDirectory / "corpus.o";
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        LLVM::Backend::Init();
+        {
+            AST ast(info);
+            ast.BuildIR();
+        }
+        state.ResumeTiming();
+
+        LLVM::Backend::BuildModule(options);
+
+        state.PauseTiming();
+        LLVM::Backend::Shutdown();
+        state.ResumeTiming();
+    }
+
+    state.SetLabel(std::string("-") + LLVM::OptimizationLevelToString(options.OptLevel));
+    SetThroughput(state, corpus);
+}
+
+BENCHMARK(BM_Lexer)->Arg(64)->Arg(512)->Arg(4096)->Arg(32768)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LexerScan)->ArgsProduct({ { 512, 4096 }, { int64_t(ScanLevel::Scalar), int64_t(GetBestScanLevel()) } })->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LexerParallel)->ArgsProduct({ { 32768 }, { 1, 2, 4 } })->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_AST)->Arg(64)->Arg(512)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FlatAST)->Arg(64)->Arg(512)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LexerAST)->ArgsProduct({ { 4096 }, { 0, 1 } })->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_IncrementalEdit)->Arg(4096)->Arg(32768)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CompileCache)->ArgsProduct({ { 4096 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Codegen)->Arg(64)->Arg(512)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FlatCodegen)->Arg(64)->Arg(512)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Emit)->ArgsProduct({ { 64, 512 }, { int64_t(LLVM::OptimizationLevel::O0), int64_t(LLVM::OptimizationLevel::O2) } })->Unit(benchmark::kMillisecond);
+
+// strips "--name=value" from argv so google benchmark doesn't reject it
+static bool ConsumeFlag(int& argc, char** argv, const char* name, std::string& value)
+{
+    const size_t length = std::strlen(name);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strncmp(argv[i], name, length) != 0 || argv[i][length] != '=')
+            continue;
+
+        value = argv[i] + length + 1;
+
+        for (int j = i; j < argc - 1; j++)
+            argv[j] = argv[j + 1];
+
+        argc--;
+        return true;
+    }
+
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    std::string savePath, baselinePath, threshold = "0.1";
+
+    ConsumeFlag(argc, argv, "--save-baseline", savePath);
+    ConsumeFlag(argc, argv, "--baseline", baselinePath);
+    ConsumeFlag(argc, argv, "--regression-threshold", threshold);
+
+    benchmark::Initialize(&argc, argv);
+
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        std::cout << "clear_bench also accepts:\n"
+                  << "  --save-baseline=<file>         write the throughput of every benchmark to file\n"
+                  << "  --baseline=<file>              compare against a saved baseline, fails on a regression\n"
+                  << "  --regression-threshold=<frac>  allowed loss of throughput before failing (default = 0.1)" << std::endl;
+        return 1;
+    }
+
+    BaselineReporter reporter;
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+    benchmark::Shutdown();
+
+    if (!savePath.empty())
+    {
+        SaveBaseline(reporter.GetResults(), savePath);
+        CLEAR_LOG_INFO("saved baseline to ", savePath);
+    }
+
+    if (!baselinePath.empty() && !CompareBaseline(LoadBaseline(baselinePath), reporter.GetResults(), std::stod(threshold)))
+        return 1;
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "CorpusGenerator.h"
+
+#include "Core/Log.h"
+
+#include <random>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+namespace clear {
+
+	static const char* s_IntegerTypes[] = { "int32", "int64", "int16", "uint32" };
+	static const char* s_FloatTypes[]   = { "float32", "float64" };
+	static const char* s_Operators[]    = { "+", "-", "*", "/" };
+	static const char* s_BracketOperators[] = { "+", "-" };
+	static const char* s_NoMulOperators[]   = { "+", "-", "/" };
+
+	class CorpusWriter
+	{
+	public:
+		CorpusWriter(const CorpusOptions& options)
+			: m_Options(options), m_Random(options.Seed)
+		{
+		}
+
+		std::string Generate()
+		{
+			for (size_t i = 0; i < m_Options.StringTable; i++)
+				_WriteString(i);
+
+			for (size_t i = 0; i < m_Options.Structs; i++)
+				_WriteStruct(i);
+
+			for (size_t i = 0; i < m_Options.Functions; i++)
+				_WriteFunction(i);
+
+			_WriteCalls();
+
+			return m_Source;
+		}
+
+	private:
+		size_t _Next(size_t max)
+		{
+			return std::uniform_int_distribution<size_t>(0, max - 1)(m_Random);
+		}
+
+		template<typename T, size_t N>
+		const T& _Pick(const T (&values)[N])
+		{
+			return values[_Next(N)];
+		}
+
+		void _WriteComment()
+		{
+			if (!m_Options.Comments)
+				return;
+
+			if (_Next(4) == 0)
+				m_Source += "/* generated block\n   with a few lines of text *\\\n";
+			else
+				m_Source += "// generated comment " + std::to_string(_Next(1000)) + "\n";
+		}
+
+		void _WriteDocumentation()
+		{
+			if (m_Options.DocumentationLines == 0)
+				return;
+
+			m_Source += "/* generated documentation\n";
+
+			for (size_t i = 0; i < m_Options.DocumentationLines; i++)
+				m_Source += "   line " + std::to_string(i) + " describes what the function below does in a sentence or two\n";
+
+			m_Source += "*\\\n";
+		}
+
+		void _WriteString(size_t index)
+		{
+			m_Source += "string t" + std::to_string(index) + " = \"entry " + std::to_string(index) + " of a generated string table";
+
+			// most strings are sliced from the source, escapes have to be decoded
+			if (_Next(8) == 0)
+				m_Source += " with \\\"escaped\\\" quotes\\n";
+
+			m_Source += "\"\n";
+		}
+
+		void _WriteStruct(size_t index)
+		{
+			_WriteComment();
+
+			m_Source += "struct S" + std::to_string(index) + ":\n";
+
+			const size_t members = 2 + _Next(4);
+
+			for (size_t i = 0; i < members; i++)
+			{
+				const char* type = _Next(3) == 0 ? _Pick(s_FloatTypes) : _Pick(s_IntegerTypes);
+				// member names are registered in the enclosing scope so they have to be unique
+				m_Source += "    " + std::string(type) + " s" + std::to_string(index) + "m" + std::to_string(i) + "\n";
+			}
+
+			m_Source += "\n";
+		}
+
+		std::string _Operand(const std::vector<std::string>& variables)
+		{
+			if (!variables.empty() && _Next(2) == 0)
+				return variables[_Next(variables.size())];
+
+			// never zero so division stays well defined
+			return std::to_string(1 + _Next(99));
+		}
+
+		std::string _Expression(const std::vector<std::string>& variables, size_t depth)
+		{
+			std::string expression = _Operand(variables);
+
+			const size_t terms = 1 + _Next(3);
+			std::string_view previous;
+			bool bracketed = false;
+
+			for (size_t i = 0; i < terms; i++)
+			{
+				// the lexer reads the "y *" in "x * y *" as a pointer type and the * in ") *" as a dereference,
+				// so brackets only sit between + and - and a * never follows another *
+				const bool bracket = depth > 0 && _Next(2) == 0;
+				const char* op = bracket || bracketed ? _Pick(s_BracketOperators) : previous == "*" ? _Pick(s_NoMulOperators) : _Pick(s_Operators);
+
+				if (bracket)
+					expression += " " + std::string(op) + " (" + _Expression(variables, depth - 1) + ")";
+				else
+					expression += " " + std::string(op) + " " + _Operand(variables);
+
+				previous = op;
+				bracketed = bracket;
+			}
+
+			return expression;
+		}
+
+		std::string _FloatExpression(size_t depth)
+		{
+			// whole numbers only, the lexer splits 12.34 into two numbers and a dot
+			auto literal = [this]() { return std::to_string(1 + _Next(99)); };
+
+			std::string expression = literal();
+
+			for (size_t i = 0; i < depth; i++)
+				expression += " " + std::string(_Pick(s_Operators)) + " " + literal();
+
+			return expression;
+		}
+
+		void _WriteFunction(size_t index)
+		{
+			_WriteComment();
+			_WriteDocumentation();
+
+			m_Source += "function f" + std::to_string(index) + "(int32 a, int32 b):\n";
+
+			std::vector<std::string> variables = { "a", "b" };
+
+			for (size_t i = 0; i < m_Options.StatementsPerFunction; i++)
+			{
+				const std::string name = "v" + std::to_string(i);
+
+				if (_Next(4) == 0)
+				{
+					m_Source += "    " + std::string(_Pick(s_FloatTypes)) + " " + name + " = " + _FloatExpression(m_Options.ExpressionDepth) + "\n";
+					continue;
+				}
+
+				m_Source += "    " + std::string(_Pick(s_IntegerTypes)) + " " + name + " = " + _Expression(variables, m_Options.ExpressionDepth) + "\n";
+				variables.push_back(name);
+			}
+
+			if (m_Options.Structs > 0 && _Next(2) == 0)
+				m_Source += "    S" + std::to_string(_Next(m_Options.Structs)) + " s\n";
+
+			m_Source += "\n";
+		}
+
+		void _WriteCalls()
+		{
+			m_Source += "int32 x = 7\n";
+
+			const size_t calls = std::min<size_t>(m_Options.Functions, 64);
+
+			for (size_t i = 0; i < calls; i++)
+				m_Source += "f" + std::to_string(_Next(m_Options.Functions)) + "(x, " + std::to_string(_Next(100)) + ")\n";
+		}
+
+	private:
+		CorpusOptions m_Options;
+		std::mt19937 m_Random;
+		std::string m_Source;
+	};
+
+	std::string GenerateCorpus(const CorpusOptions& options)
+	{
+		CorpusWriter writer(options);
+		return writer.Generate();
+	}
+
+	Corpus WriteCorpus(const CorpusOptions& options, const std::filesystem::path& directory, const std::string& name)
+	{
+		Corpus corpus;
+		corpus.Source = GenerateCorpus(options);
+		corpus.Lines = std::count(corpus.Source.begin(), corpus.Source.end(), '\n');
+		corpus.Path = directory / (name + ".cl");
+
+		std::filesystem::create_directories(directory);
+
+		std::ofstream stream(corpus.Path, std::ios::binary);
+		CLEAR_VERIFY(stream.is_open(), "failed to write corpus ", corpus.Path.string());
+
+		stream << corpus.Source;
+		return corpus;
+	}
+
+}
\ No newline at end of file
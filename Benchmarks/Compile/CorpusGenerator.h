@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <filesystem>
+
+namespace clear {
+
+	struct CorpusOptions
+	{
+		size_t Functions = 100;
+		size_t Structs = 10;
+		size_t StatementsPerFunction = 4;
+		size_t ExpressionDepth = 3; // how deeply bracketed sub expressions are nested
+		bool Comments = true;
+		size_t DocumentationLines = 0; // lines of block comment written before every function
+		size_t StringTable = 0; // string declarations written first, the code generator can't handle strings yet so only lex these
+		uint32_t Seed = 1;
+	};
+
+	struct Corpus
+	{
+		std::filesystem::path Path;
+		std::string Source;
+		size_t Lines = 0;
+	};
+
+	// generates a deterministic program that only uses what the parser and code generator support,
+	// so the same options always produce the same source
+	extern std::string GenerateCorpus(const CorpusOptions& options);
+
+	// generates the program and writes it to directory/<name>.cl
+	extern Corpus WriteCorpus(const CorpusOptions& options, const std::filesystem::path& directory, const std::string& name);
+
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+// every kernel, clear or c, defines this. the result depends on every local so none of the work can be removed
+extern int64_t bench(int32_t a, int32_t b);
+
+int main(int argc, char** argv)
+{
+    const long long iterations = argc > 1 ? atoll(argv[1]) : 10000000;
+
+    // volatile so the arguments can't be assumed constant
+    volatile int32_t a = 3;
+    volatile int32_t b = 7;
+
+    volatile int64_t result = 0;
+
+    struct timespec start, end;
+    timespec_get(&start, TIME_UTC);
+
+    for (long long i = 0; i < iterations; i++)
+        result = bench(a, b);
+
+    timespec_get(&end, TIME_UTC);
+
+    const double nanoseconds = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    // the result is printed after the time, a clear kernel and its c twin have to agree on it
+    printf("%f\n%lld\n", nanoseconds / (double)iterations, (long long)result);
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#include <stdint.h>
+
+int64_t bench(int a, int b)
+{
+    double x = a * 3.0 / 2.0;
+    double y = x * x + 9.0 / 4.0;
+    double z = (y - x) / 9.0 * 2.0 + b;
+    float s = a / 2.0f - 5.0f / 4.0f;
+    float t = s * s + (s - 7.0f / 2.0f);
+    double u = z * t - y / 2.0;
+    double scaled = u * 1000.0;
+
+    return (int64_t)scaled;
+}
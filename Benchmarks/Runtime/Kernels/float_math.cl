@@ -0,0 +1,11 @@
+// floating point math mixed with integer parameters. the lexer has no decimal literals yet, so the constants are
+// whole numbers that are converted to the type being assigned
+function bench(int32 a, int32 b) -> int64:
+    float64 x = a * 3 / 2
+    float64 y = x * x + 9 / 4
+    float64 z = (y - x) / 9 * 2 + b
+    float32 s = a / 2 - 5 / 4
+    float32 t = s * s + (s - 7 / 2)
+    float64 u = z * t - y / 2
+    float64 scaled = u * 1000
+    return scaled
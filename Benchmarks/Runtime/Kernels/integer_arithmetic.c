@@ -0,0 +1,15 @@
+#include <stdint.h>
+
+int64_t bench(int32_t a, int32_t b)
+{
+    int32_t c = a + b * 3;
+    int32_t d = (c - a) / 2 + b;
+    int64_t e = (int64_t)c * d - ((int64_t)a + 7);
+    int64_t f = e / 3 + 5 * ((int64_t)d - c);
+    int32_t g = a * a + b * b - c;
+    int32_t h = (g + 11) / (b + 1) - d;
+    int64_t i = f - e * 2 + (h - 4);
+    int32_t j = h * 7 - (g / 5 + a);
+
+    return i + j;
+}
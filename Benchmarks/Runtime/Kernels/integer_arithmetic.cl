@@ -0,0 +1,11 @@
+// integer arithmetic, the driver calls bench in a loop since the language has no loops yet
+function bench(int32 a, int32 b) -> int64:
+    int32 c = a + b * 3
+    int32 d = (c - a) / 2 + b
+    int64 e = c * d - (a + 7)
+    int64 f = e / 3 + 5 * (d - c)
+    int32 g = a * a + b * b - c
+    int32 h = (g + 11) / (b + 1) - d
+    int64 i = f - e * 2 + (h - 4)
+    int32 j = h * 7 - (g / 5 + a)
+    return i + j
@@ -0,0 +1,17 @@
+#include <stdint.h>
+
+// clear converts every operand to the type being assigned before the arithmetic, extending by the signedness
+// of that type, and always divides signed. the casts below do the same
+int64_t bench(int32_t a, int32_t b)
+{
+    int8_t c = (int8_t)((int8_t)a + 1);
+    int16_t d = (int16_t)(c * (int16_t)b - 3);
+    int64_t e = (int64_t)d * a + c;
+    uint32_t f = (uint32_t)e - (uint32_t)(uint16_t)d / 2;
+    int8_t g = (int8_t)((int8_t)f + c - (int8_t)b);
+    int64_t h = e * ((int64_t)g + d) - g - d;
+    uint8_t i = (uint8_t)((int8_t)h / 3 + (uint8_t)g);
+    int16_t j = (int16_t)((int8_t)i * 2 - ((int16_t)f + 5));
+
+    return c + d + e + (int32_t)f + g + h + (int8_t)i + j;
+}
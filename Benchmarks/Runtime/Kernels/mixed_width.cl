@@ -0,0 +1,11 @@
+// integer widths that need casts on every use, exercises AbstractType::CastValue
+function bench(int32 a, int32 b) -> int64:
+    int8 c = a + 1
+    int16 d = c * b - 3
+    int64 e = d * a + c
+    uint32 f = e - d / 2
+    int8 g = f + c - b
+    int64 h = e * (g + d) - g - d
+    uint8 i = h / 3 + g
+    int16 j = i * 2 - (f + 5)
+    return c + d + e + f + g + h + i + j
@@ -0,0 +1,28 @@
+#include <stdint.h>
+
+struct Vec3
+{
+    double vx;
+    double vy;
+    double vz;
+};
+
+struct Particle
+{
+    struct Vec3 position;
+    struct Vec3 velocity;
+    int32_t id;
+    int64_t age;
+};
+
+int64_t bench(int32_t a, int32_t b)
+{
+    struct Particle p;
+    struct Particle q;
+    struct Vec3 v;
+    int32_t id = a * 3 + b;
+    int64_t age = (int64_t)id * (b - 1);
+    struct Vec3 w;
+
+    return id + age;
+}
@@ -0,0 +1,21 @@
+// placeholder: member access isn't supported yet, so the structs are only allocated and both compilers remove them.
+// it isn't reported until the kernel can do real work on its members
+struct Vec3:
+    float64 vx
+    float64 vy
+    float64 vz
+
+struct Particle:
+    Vec3 position
+    Vec3 velocity
+    int32 id
+    int64 age
+
+function bench(int32 a, int32 b) -> int64:
+    Particle p
+    Particle q
+    Vec3 v
+    int32 id = a * 3 + b
+    int64 age = id * (b - 1)
+    Vec3 w
+    return id + age
@@ -0,0 +1,241 @@
+#include "Parsing/Parser.h"
+#include "AST/AST.h"
+#include "API/LLVM/LLVMBackend.h"
+#include "Core/Log.h"
+
+#include <llvm/Support/Program.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <limits>
+#include <optional>
+
+using namespace clear;
+
+static llvm::cl::opt<std::string> s_KernelDirectory("kernels", llvm::cl::desc("Directory of <kernel>.cl programs and their <kernel>.c twins"),
+                                                    llvm::cl::value_desc("directory"), llvm::cl::init(CLEAR_RUNTIME_BENCH_DIR "/Kernels"));
+
+static llvm::cl::opt<std::string> s_Driver("driver", llvm::cl::desc("C program that times calls to bench(a, b)"),
+                                           llvm::cl::value_desc("filename"), llvm::cl::init(CLEAR_RUNTIME_BENCH_DIR "/Driver.c"));
+
+static llvm::cl::opt<std::string> s_CCompiler("cc", llvm::cl::desc("C compiler used for the twins and for linking"),
+                                              llvm::cl::value_desc("compiler"), llvm::cl::init(CLEAR_C_COMPILER));
+
+static llvm::cl::opt<std::string> s_WorkDirectory("work-dir", llvm::cl::desc("Directory the objects and executables are written to"),
+                                                  llvm::cl::value_desc("directory"));
+
+static llvm::cl::list<char> s_OptimizationLevels("O", llvm::cl::desc("Optimization levels to compare at, can be repeated (default = -O0 -O2)"),
+                                                 llvm::cl::Prefix);
+
+static llvm::cl::opt<std::string> s_Filter("filter", llvm::cl::desc("Only run kernels whose name contains this"),
+                                           llvm::cl::value_desc("text"));
+
+static llvm::cl::opt<uint64_t> s_Iterations("iterations", llvm::cl::desc("Calls to bench per run (default = 10000000)"),
+                                            llvm::cl::init(10000000));
+
+static llvm::cl::opt<uint32_t> s_Repetitions("repetitions", llvm::cl::desc("Runs per executable, the fastest is reported (default = 3)"),
+                                             llvm::cl::init(3));
+
+struct Kernel
+{
+    std::string Name;
+    std::filesystem::path ClearSource;
+    std::filesystem::path CSource;
+};
+
+// a kernel that can't do the work it is named after yet starts with a "// placeholder" comment
+static bool IsPlaceholder(const Kernel& kernel)
+{
+    std::ifstream file(kernel.ClearSource);
+
+    std::string line;
+    std::getline(file, line);
+
+    return line.starts_with("// placeholder");
+}
+
+static std::vector<Kernel> FindKernels()
+{
+    std::vector<Kernel> kernels;
+
+    for (const auto& entry : std::filesystem::directory_iterator(s_KernelDirectory.c_str()))
+    {
+        const std::filesystem::path& path = entry.path();
+
+        if (path.extension() != ".cl")
+            continue;
+
+        Kernel kernel;
+        kernel.Name = path.stem().string();
+        kernel.ClearSource = path;
+        kernel.CSource = std::filesystem::path(path).replace_extension(".c");
+
+        if (!s_Filter.empty() && kernel.Name.find(s_Filter) == std::string::npos)
+            continue;
+
+        if (!std::filesystem::exists(kernel.CSource))
+        {
+            CLEAR_LOG_WARNING("skipping ", kernel.Name, ", it has no c twin");
+            continue;
+        }
+
+        if (IsPlaceholder(kernel))
+        {
+            CLEAR_LOG_WARNING("skipping ", kernel.Name, ", it is a placeholder");
+            continue;
+        }
+
+        kernels.push_back(kernel);
+    }
+
+    std::sort(kernels.begin(), kernels.end(), [](const Kernel& a, const Kernel& b) { return a.Name < b.Name; });
+    return kernels;
+}
+
+// runs a program, its stdout is written to output when given, returns false if it didn't exit cleanly
+static bool Execute(const std::string& program, const std::vector<std::string>& args, const std::filesystem::path& output = {})
+{
+    std::vector<llvm::StringRef> argv = { program };
+
+    for (const auto& arg : args)
+        argv.push_back(arg);
+
+    std::string outputPath = output.string();
+    std::optional<llvm::StringRef> redirects[] = { std::nullopt, llvm::StringRef(outputPath), std::nullopt };
+
+    llvm::ArrayRef<std::optional<llvm::StringRef>> redirectStreams;
+
+    if (!output.empty())
+        redirectStreams = redirects;
+
+    std::string error;
+    int result = llvm::sys::ExecuteAndWait(program, argv, std::nullopt, redirectStreams, 0, 0, &error);
+
+    if (result != 0)
+        CLEAR_LOG_ERROR(program, " failed (", result, ") ", error);
+
+    return result == 0;
+}
+
+static void CompileClearKernel(const Kernel& kernel, LLVM::OptimizationLevel level, const std::filesystem::path& object)
+{
+    Parser parser;
+    ProgramInfo info = parser.CreateTokensFromFile(kernel.ClearSource);
+
+    LLVM::BuildOptions options;
+    options.OptLevel = level;
+    options.OutputPath = object;
+
+    LLVM::Backend::Init();
+
+    {
+        // the driver owns main
+        AST ast(info, "clear_kernel_main");
+        ast.BuildIR();
+    }
+
+    LLVM::Backend::BuildModule(options);
+    LLVM::Backend::Shutdown();
+}
+
+// returns the fastest time per call in nanoseconds, result is what bench returned
+static double RunKernel(const std::filesystem::path& executable, const std::filesystem::path& output, int64_t& result)
+{
+    double best = std::numeric_limits<double>::max();
+
+    for (uint32_t i = 0; i < s_Repetitions; i++)
+    {
+        if (!Execute(executable.string(), { std::to_string(s_Iterations) }, output))
+            return 0.0;
+
+        auto buffer = llvm::MemoryBuffer::getFile(output.string());
+        CLEAR_VERIFY(buffer, "failed to read ", output.string());
+
+        std::istringstream stream((*buffer)->getBuffer().str());
+
+        double time = 0.0;
+        stream >> time >> result;
+
+        CLEAR_VERIFY(stream, "failed to parse the output of ", executable.string());
+
+        best = std::min(best, time);
+    }
+
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    llvm::cl::ParseCommandLineOptions(argc, argv, "clear runtime benchmarks, compares generated code against c twins\n");
+
+    std::vector<char> levels(s_OptimizationLevels.begin(), s_OptimizationLevels.end());
+
+    if (levels.empty())
+        levels = { '0', '2' };
+
+    auto compiler = llvm::sys::findProgramByName(s_CCompiler);
+    CLEAR_VERIFY(compiler, "failed to find c compiler ", s_CCompiler);
+
+    std::filesystem::path workDirectory = s_WorkDirectory.empty() ? std::filesystem::temp_directory_path() / "clear_runtime_bench"
+                                                                  : std::filesystem::absolute(s_WorkDirectory.c_str());
+
+    std::filesystem::create_directories(workDirectory);
+
+    std::vector<Kernel> kernels = FindKernels();
+    CLEAR_VERIFY(!kernels.empty(), "no kernels found in ", s_KernelDirectory);
+
+    bool failed = false;
+
+    std::cout << std::left << std::setw(24) << "Kernel" << std::setw(8) << "Level"
+              << std::right << std::setw(14) << "clear (ns)" << std::setw(14) << "c (ns)" << std::setw(10) << "Ratio" << std::endl;
+
+    for (const Kernel& kernel : kernels)
+    {
+        for (char level : levels)
+        {
+            const std::string flag = std::string("-O") + level;
+            const std::filesystem::path base = workDirectory / (kernel.Name + flag);
+
+            CompileClearKernel(kernel, LLVM::OptimizationLevelFromChar(level), base.string() + ".clear.o");
+
+            // no fused multiply adds, clear never emits them and the float results would stop matching
+            bool built = Execute(*compiler, { flag, "-ffp-contract=off", "-c", kernel.CSource.string(), "-o", base.string() + ".c.o" }) &&
+                         Execute(*compiler, { flag, s_Driver, base.string() + ".clear.o", "-o", base.string() + ".clear" }) &&
+                         Execute(*compiler, { flag, s_Driver, base.string() + ".c.o", "-o", base.string() + ".c" });
+
+            int64_t clearResult = 0;
+            int64_t cResult = 0;
+
+            double clearTime = built ? RunKernel(base.string() + ".clear", base.string() + ".clear.txt", clearResult) : 0.0;
+            double cTime     = built ? RunKernel(base.string() + ".c", base.string() + ".c.txt", cResult) : 0.0;
+
+            if (clearTime <= 0.0 || cTime <= 0.0)
+            {
+                CLEAR_LOG_ERROR("failed to benchmark ", kernel.Name, " at ", flag);
+                failed = true;
+                continue;
+            }
+
+            // a kernel that computes something else than its twin isn't a fair comparison
+            if (clearResult != cResult)
+            {
+                CLEAR_LOG_ERROR(kernel.Name, " at ", flag, " returned ", clearResult, ", its c twin returned ", cResult);
+                failed = true;
+                continue;
+            }
+
+            // a ratio above 1 means the clear kernel is slower than its c twin
+            std::cout << std::left << std::setw(24) << kernel.Name << std::setw(8) << flag << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(14) << clearTime << std::setw(14) << cTime << std::setw(10) << clearTime / cTime << std::defaultfloat << std::endl;
+        }
+    }
+
+    return failed ? 1 : 0;
+}
\ No newline at end of file
@@ -1,60 +1,463 @@
 #include "LLVMBackend.h"
 
 #include "Core/Log.h"
+#include "Core/Profiler.h"
+#include "Core/Utils.h"
 
 #include <filesystem>
+#include <algorithm>
+#include <mutex>
 
 namespace clear {
 	namespace LLVM {
 
+		const char* OptimizationLevelToString(OptimizationLevel level)
+		{
+			switch (level)
+			{
+				case OptimizationLevel::O0: return "O0";
+				case OptimizationLevel::O1: return "O1";
+				case OptimizationLevel::O2: return "O2";
+				case OptimizationLevel::O3: return "O3";
+				case OptimizationLevel::Os: return "Os";
+				case OptimizationLevel::Oz: return "Oz";
+				default:
+					break;
+			}
+
+			return "";
+		}
+
+		OptimizationLevel OptimizationLevelFromChar(char level)
+		{
+			switch (level)
+			{
+				case '0': return OptimizationLevel::O0;
+				case '1': return OptimizationLevel::O1;
+				case '2': return OptimizationLevel::O2;
+				case '3': return OptimizationLevel::O3;
+				case 's': return OptimizationLevel::Os;
+				case 'z': return OptimizationLevel::Oz;
+				default:
+					break;
+			}
+
+			CLEAR_ANNOTATED_HALT("invalid optimization level -O", level);
+			return OptimizationLevel::O0;
+		}
+
+		static llvm::OptimizationLevel GetLLVMOptimizationLevel(OptimizationLevel level)
+		{
+			switch (level)
+			{
+				case OptimizationLevel::O1: return llvm::OptimizationLevel::O1;
+				case OptimizationLevel::O2: return llvm::OptimizationLevel::O2;
+				case OptimizationLevel::O3: return llvm::OptimizationLevel::O3;
+				case OptimizationLevel::Os: return llvm::OptimizationLevel::Os;
+				case OptimizationLevel::Oz: return llvm::OptimizationLevel::Oz;
+				case OptimizationLevel::O0:
+				default:
+					break;
+			}
+
+			return llvm::OptimizationLevel::O0;
+		}
+
+		static llvm::CodeGenOptLevel GetCodeGenOptLevel(OptimizationLevel level)
+		{
+			switch (level)
+			{
+				case OptimizationLevel::O0: return llvm::CodeGenOptLevel::None;
+				case OptimizationLevel::O1: return llvm::CodeGenOptLevel::Less;
+				case OptimizationLevel::O3: return llvm::CodeGenOptLevel::Aggressive;
+				case OptimizationLevel::O2:
+				case OptimizationLevel::Os:
+				case OptimizationLevel::Oz:
+				default:
+					break;
+			}
+
+			return llvm::CodeGenOptLevel::Default;
+		}
+
+		static void InitializeTargets()
+		{
+			// only the targets we link against in CMakeLists.txt can be registered,
+			// the once flag keeps this safe to call from the build threads
+			static std::once_flag s_Initialized;
+
+			std::call_once(s_Initialized, []()
+				{
+					LLVMInitializeX86TargetInfo();
+					LLVMInitializeX86Target();
+					LLVMInitializeX86TargetMC();
+					LLVMInitializeX86AsmPrinter();
+					LLVMInitializeX86AsmParser();
+
+					LLVMInitializeAArch64TargetInfo();
+					LLVMInitializeAArch64Target();
+					LLVMInitializeAArch64TargetMC();
+					LLVMInitializeAArch64AsmPrinter();
+					LLVMInitializeAArch64AsmParser();
+				});
+		}
+
+		static std::string GetHostFeatures()
+		{
+			llvm::StringMap<bool> hostFeatures = llvm::sys::getHostCPUFeatures();
+
+			std::string features;
+
+			for (const auto& feature : hostFeatures)
+			{
+				if (!features.empty())
+					features += ',';
+
+				features += feature.getValue() ? '+' : '-';
+				features += feature.getKey().str();
+			}
+
+			return features;
+		}
+
 		void Backend::Init()
 		{
-			s_Context = std::make_shared<llvm::LLVMContext>();
-			s_Module  = std::make_shared<llvm::Module>("clear", *s_Context);
-			s_Builder = std::make_shared<llvm::IRBuilder<>>(*s_Context);
+			CreateModule("clear");
 		}
 
 		void Backend::Shutdown()
 		{
-			s_Builder.reset();
-			s_Module.reset();
-			s_Context.reset();
+			for (auto& module : s_Modules)
+			{
+				module.Builder.reset();
+				module.Module.reset();
+				module.Context.reset();
+			}
+
+			s_Modules.clear();
+			s_CurrentModule = 0;
+		}
+
+		size_t Backend::CreateModule(const std::string& name)
+		{
+			ModuleData& data = s_Modules.emplace_back();
+
+			data.Context = std::make_unique<llvm::LLVMContext>();
+			data.Module  = std::make_unique<llvm::Module>(name, *data.Context);
+			data.Builder = std::make_unique<llvm::IRBuilder<>>(*data.Context);
+
+			s_CurrentModule = s_Modules.size() - 1;
+			return s_CurrentModule;
+		}
+
+		void Backend::SetCurrentModule(size_t index)
+		{
+			CLEAR_VERIFY(index < s_Modules.size(), "module index out of range");
+			s_CurrentModule = index;
+		}
+
+		void Backend::BuildModule(const BuildOptions& options)
+		{
+			CLEAR_PROFILE_SCOPE("Backend::BuildModule");
+
+			auto& module = *GetModule();
+			auto targetMachine = _CreateTargetMachine(options);
+
+			module.setDataLayout(targetMachine->createDataLayout());
+			module.setTargetTriple(targetMachine->getTargetTriple().str());
+
+			_RunOptimizationPipeline(module, targetMachine.get(), options);
+
+			if (options.SplitCount <= 1)
+			{
+				_EmitObject(module, targetMachine.get(), options.OutputPath);
+				return;
+			}
+
+			// the module is optimized as a whole first so inlining etc... still sees every function,
+			// after that each part is independent and can be code generated on its own thread
+			const std::string targetTriple = module.getTargetTriple();
+			std::vector<llvm::SmallString<0>> parts;
+
+			{
+				CLEAR_PROFILE_SCOPE("Backend::SplitModule");
+
+				llvm::SplitModule(module, options.SplitCount, [&](std::unique_ptr<llvm::Module> part)
+					{
+						// contexts are not thread safe, so parts travel to the workers as bitcode
+						llvm::SmallString<0>& bitcode = parts.emplace_back();
+						llvm::raw_svector_ostream stream(bitcode);
+						llvm::WriteBitcodeToFile(*part, stream);
+					});
+			}
+
+			std::filesystem::path outputDirectory = std::filesystem::absolute(options.OutputPath).parent_path();
+			std::string outputStem = options.OutputPath.stem().string();
+
+			std::vector<std::filesystem::path> objects;
+			for (size_t i = 0; i < parts.size(); i++)
+				objects.push_back(outputDirectory / (outputStem + "." + std::to_string(i) + ".o"));
+
+			{
+				CLEAR_PROFILE_SCOPE("Backend::CodegenParts");
+
+				ParallelFor(parts.size(), options.Threads, [&](size_t i)
+					{
+						CLEAR_PROFILE_SCOPE("Backend::CodegenPart");
+
+						llvm::LLVMContext context;
+
+						llvm::MemoryBufferRef buffer(llvm::StringRef(parts[i].data(), parts[i].size()), objects[i].string());
+						auto part = llvm::parseBitcodeFile(buffer, context);
+						CLEAR_VERIFY(part, "failed to read module part: ", llvm::toString(part.takeError()));
+
+						auto partTargetMachine = _CreateTargetMachine(options);
+						_EmitObject(**part, partTargetMachine.get(), objects[i]);
+					});
+			}
+
+			std::filesystem::path archive = options.OutputPath;
+			archive.replace_extension(".a");
+
+			_WriteArchive(objects, archive, targetTriple);
 		}
 
-		void Backend::BuildModule() //TODO: be able to change output filepath
+		void Backend::BuildModules(const BuildOptions& options)
 		{
-			llvm::InitializeNativeTarget();
-			llvm::InitializeNativeTargetAsmPrinter();
-			llvm::InitializeNativeTargetAsmParser();
+			CLEAR_PROFILE_SCOPE("Backend::BuildModules");
+
+			std::filesystem::path outputDirectory = std::filesystem::absolute(options.OutputPath).parent_path();
+
+			std::vector<std::filesystem::path> objects;
+			for (auto& data : s_Modules)
+				objects.push_back(outputDirectory / (data.Module->getName().str() + ".o"));
+
+			// the first target machine is created up front so bad target options fail before any threads start
+			std::unique_ptr<llvm::TargetMachine> firstTargetMachine = _CreateTargetMachine(options);
+			const std::string targetTriple = firstTargetMachine->getTargetTriple().str();
+			firstTargetMachine.reset();
+
+			ParallelFor(s_Modules.size(), options.Threads, [&](size_t i)
+				{
+					// target machines are not thread safe so every module gets its own
+					auto& module = *s_Modules[i].Module;
+					CLEAR_PROFILE_SCOPE(module.getName());
 
-			auto TargetTriple = llvm::sys::getDefaultTargetTriple();
+					auto targetMachine = _CreateTargetMachine(options);
+
+					module.setDataLayout(targetMachine->createDataLayout());
+					module.setTargetTriple(targetTriple);
+
+					_RunOptimizationPipeline(module, targetMachine.get(), options);
+					_EmitObject(module, targetMachine.get(), objects[i]);
+				});
+
+			std::filesystem::path archive = options.OutputPath;
+			archive.replace_extension(".a");
+
+			_WriteArchive(objects, archive, targetTriple);
+		}
+
+		int Backend::RunModule(const BuildOptions& options)
+		{
+			CLEAR_VERIFY(options.TargetTriple.empty(), "cannot run a module compiled for another target");
+
+			InitializeTargets();
+
+			auto targetMachineBuilder = llvm::orc::JITTargetMachineBuilder::detectHost();
+			CLEAR_VERIFY(targetMachineBuilder, "failed to detect host for jit: ", llvm::toString(targetMachineBuilder.takeError()));
+
+			// the program runs on this machine so tune for the host unless a specific cpu was asked for
+			if (!options.CPU.empty() && options.CPU != "generic" && options.CPU != "native")
+			{
+				targetMachineBuilder->setCPU(options.CPU);
+				targetMachineBuilder->getFeatures() = llvm::SubtargetFeatures();
+			}
+
+			if (!options.Features.empty())
+				targetMachineBuilder->addFeatures({ options.Features });
+
+			targetMachineBuilder->setCodeGenOptLevel(GetCodeGenOptLevel(options.OptLevel));
+
+			auto targetMachine = targetMachineBuilder->createTargetMachine();
+			CLEAR_VERIFY(targetMachine, "failed to create jit target machine: ", llvm::toString(targetMachine.takeError()));
+
+			auto jit = llvm::orc::LLJITBuilder().setJITTargetMachineBuilder(std::move(*targetMachineBuilder)).create();
+			CLEAR_VERIFY(jit, "failed to create jit: ", llvm::toString(jit.takeError()));
+
+			// let programs call into the c runtime the process is already linked against (sleep etc...)
+			auto processSymbols = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess((*jit)->getDataLayout().getGlobalPrefix());
+			CLEAR_VERIFY(processSymbols, "failed to load process symbols: ", llvm::toString(processSymbols.takeError()));
+			(*jit)->getMainJITDylib().addGenerator(std::move(*processSymbols));
+
+			bool returnsInteger = false;
+			bool foundMain = false;
+
+			for (auto& data : s_Modules)
+			{
+				CLEAR_PROFILE_SCOPE(data.Module->getName());
+
+				data.Module->setDataLayout((*targetMachine)->createDataLayout());
+				data.Module->setTargetTriple((*targetMachine)->getTargetTriple().str());
+
+				_RunOptimizationPipeline(*data.Module, targetMachine->get(), options);
+
+				if (llvm::Function* mainFunction = data.Module->getFunction("main"); mainFunction && !mainFunction->isDeclaration())
+				{
+					returnsInteger = mainFunction->getReturnType()->isIntegerTy();
+					foundMain = true;
+				}
+
+				data.Builder.reset();
+				llvm::orc::ThreadSafeModule module(std::move(data.Module), std::move(data.Context));
+
+				llvm::Error error = (*jit)->addIRModule(std::move(module));
+				CLEAR_VERIFY(!error, "failed to add module to jit: ", llvm::toString(std::move(error)));
+			}
+
+			CLEAR_VERIFY(foundMain, "program has no main function");
+
+			// looking main up is what makes the jit compile the modules
+			ProfileTimer compileTimer("Backend::JITCompile");
+
+			auto mainSymbol = (*jit)->lookup("main");
+			CLEAR_VERIFY(mainSymbol, "failed to find main: ", llvm::toString(mainSymbol.takeError()));
+
+			compileTimer.Stop();
+
+			if (returnsInteger)
+				return mainSymbol->toPtr<int (*)()>()();
+
+			mainSymbol->toPtr<void (*)()>()();
+			return 0;
+		}
+
+		std::unique_ptr<llvm::TargetMachine> Backend::_CreateTargetMachine(const BuildOptions& options)
+		{
+			InitializeTargets();
+
+			std::string targetTriple = options.TargetTriple.empty() ? llvm::sys::getDefaultTargetTriple()
+																	: llvm::Triple::normalize(options.TargetTriple);
 
 			std::string error;
-			const llvm::Target* target = llvm::TargetRegistry::lookupTarget(TargetTriple, error);
-			CLEAR_VERIFY(target, "failed to find target");
+			const llvm::Target* target = llvm::TargetRegistry::lookupTarget(targetTriple, error);
+			CLEAR_VERIFY(target, "failed to find target ", targetTriple, ": ", error);
+
+			std::string cpu = options.CPU.empty() ? "generic" : options.CPU;
+			std::string features;
+
+			if (cpu == "native")
+			{
+				CLEAR_VERIFY(llvm::Triple(targetTriple).getArch() == llvm::Triple(llvm::sys::getProcessTriple()).getArch(),
+							 "-mcpu=native can only be used when targeting the host architecture");
 
-			auto cpu = "generic";
-			auto features = "";
+				cpu = llvm::sys::getHostCPUName().str();
+				features = GetHostFeatures();
+			}
+
+			if (!options.Features.empty())
+				features += features.empty() ? options.Features : "," + options.Features;
 
 			llvm::TargetOptions opt;
-			auto targetMachine = target->createTargetMachine(TargetTriple, cpu, features, opt, llvm::Reloc::PIC_);
+			std::unique_ptr<llvm::TargetMachine> targetMachine(target->createTargetMachine(targetTriple, cpu, features, opt, llvm::Reloc::PIC_));
+			CLEAR_VERIFY(targetMachine, "failed to create target machine for ", targetTriple);
+
+			targetMachine->setOptLevel(GetCodeGenOptLevel(options.OptLevel));
+
+			return targetMachine;
+		}
+
+		void Backend::_RunOptimizationPipeline(llvm::Module& module, llvm::TargetMachine* targetMachine, const BuildOptions& options)
+		{
+			CLEAR_PROFILE_SCOPE("Backend::Optimize");
+
+			llvm::LoopAnalysisManager     loopAnalysis;
+			llvm::FunctionAnalysisManager functionAnalysis;
+			llvm::CGSCCAnalysisManager    cgsccAnalysis;
+			llvm::ModuleAnalysisManager   moduleAnalysis;
+
+			llvm::PassInstrumentationCallbacks instrumentation;
+			llvm::PassBuilder passBuilder(targetMachine, llvm::PipelineTuningOptions(), {}, &instrumentation);
+
+			if (Profiler::IsEnabled())
+			{
+				// merges the timing of every pass and analysis into the same trace as the rest of the compiler
+				instrumentation.registerBeforeNonSkippedPassCallback([](llvm::StringRef pass, llvm::Any) { Profiler::BeginEvent(pass, "pass"); });
+				instrumentation.registerAfterPassCallback([](llvm::StringRef, llvm::Any, const llvm::PreservedAnalyses&) { Profiler::EndEvent(); });
+				instrumentation.registerAfterPassInvalidatedCallback([](llvm::StringRef, const llvm::PreservedAnalyses&) { Profiler::EndEvent(); });
+				instrumentation.registerBeforeAnalysisCallback([](llvm::StringRef analysis, llvm::Any) { Profiler::BeginEvent(analysis, "analysis"); });
+				instrumentation.registerAfterAnalysisCallback([](llvm::StringRef, llvm::Any) { Profiler::EndEvent(); });
+			}
+
+			passBuilder.registerModuleAnalyses(moduleAnalysis);
+			passBuilder.registerCGSCCAnalyses(cgsccAnalysis);
+			passBuilder.registerFunctionAnalyses(functionAnalysis);
+			passBuilder.registerLoopAnalyses(loopAnalysis);
+			passBuilder.crossRegisterProxies(loopAnalysis, functionAnalysis, cgsccAnalysis, moduleAnalysis);
+
+			llvm::OptimizationLevel level = GetLLVMOptimizationLevel(options.OptLevel);
 
-			s_Module->setDataLayout(targetMachine->createDataLayout());
-			s_Module->setTargetTriple(TargetTriple);
+			llvm::ModulePassManager modulePasses = level == llvm::OptimizationLevel::O0
+				? passBuilder.buildO0DefaultPipeline(level)
+				: passBuilder.buildPerModuleDefaultPipeline(level);
 
-			std::filesystem::path path = std::filesystem::current_path() / "Tests" / "output.o";
+			if (options.PrintPipeline)
+			{
+				std::string pipeline;
+				llvm::raw_string_ostream stream(pipeline);
+
+				modulePasses.printPipeline(stream, [&](llvm::StringRef className)
+					{
+						llvm::StringRef passName = instrumentation.getPassNameForClassName(className);
+						return passName.empty() ? className : passName;
+					});
+
+				CLEAR_LOG_INFO("running -", OptimizationLevelToString(options.OptLevel), " pipeline: ", stream.str());
+			}
+
+			modulePasses.run(module, moduleAnalysis);
+		}
+
+		void Backend::_WriteArchive(const std::vector<std::filesystem::path>& objects, const std::filesystem::path& archive, const std::string& targetTriple)
+		{
+			CLEAR_PROFILE_SCOPE("Backend::WriteArchive");
+
+			// members keep references to their names so the strings have to outlive the archive write
+			std::vector<std::string> objectPaths;
+			for (const auto& object : objects)
+				objectPaths.push_back(object.string());
+
+			std::vector<llvm::NewArchiveMember> members;
+			for (const auto& objectPath : objectPaths)
+			{
+				auto member = llvm::NewArchiveMember::getFile(objectPath, true);
+				CLEAR_VERIFY(member, "failed to read object ", objectPath, ": ", llvm::toString(member.takeError()));
+
+				member->MemberName = llvm::sys::path::filename(objectPath);
+				members.push_back(std::move(*member));
+			}
+
+			auto kind = llvm::Triple(targetTriple).isOSDarwin() ? llvm::object::Archive::K_DARWIN : llvm::object::Archive::K_GNU;
+
+			llvm::Error error = llvm::writeArchive(archive.string(), members, llvm::SymtabWritingMode::NormalSymtab, kind, true, false);
+			CLEAR_VERIFY(!error, "failed to write archive ", archive.string(), ": ", llvm::toString(std::move(error)));
+		}
+
+		void Backend::_EmitObject(llvm::Module& module, llvm::TargetMachine* targetMachine, const std::filesystem::path& path)
+		{
+			CLEAR_PROFILE_SCOPE("Backend::EmitObject");
 
 			std::error_code EC;
 			llvm::raw_fd_ostream dest(path.string(), EC, llvm::sys::fs::OF_None);
 
-			CLEAR_VERIFY(!EC, "could not open file");
+			CLEAR_VERIFY(!EC, "could not open file ", path.string());
 
 			llvm::legacy::PassManager pass;
 			auto fileType = llvm::CodeGenFileType::ObjectFile;
 
 			CLEAR_VERIFY(!(targetMachine->addPassesToEmitFile(pass, dest, nullptr, fileType)), "TargetMachine can't emit a file of this type");
 
-			pass.run(*s_Module);
+			pass.run(module);
 			dest.flush();
 		}
 
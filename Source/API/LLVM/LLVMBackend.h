@@ -1,29 +1,85 @@
-#pragma once 
+#pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <functional>
 
 #include "LLVMInclude.h"
 
 namespace clear {
 	namespace LLVM {
 
-		//TODO: need to make this support multiple modules
+		enum class OptimizationLevel
+		{
+			O0 = 0, O1, O2, O3, Os, Oz
+		};
+
+		struct BuildOptions
+		{
+			OptimizationLevel OptLevel = OptimizationLevel::O0;
+			bool PrintPipeline = false;
+
+			std::string TargetTriple; // empty uses the default triple of the host
+			std::string CPU = "generic"; // "native" detects the host cpu and its features
+			std::string Features; // e.g "+avx2,-sse4.1", applied after any host features
+
+			std::filesystem::path OutputPath = "Tests/output.o"; // relative paths are relative to the working directory
+			uint32_t Threads = 0; // worker threads used for parallel code generation, 0 uses one per hardware thread
+			uint32_t SplitCount = 1; // BuildModule splits the optimized module into this many parts that are code generated in parallel
+		};
+
+		extern const char* OptimizationLevelToString(OptimizationLevel level);
+
+		// the character after -O, halts on anything else
+		extern OptimizationLevel OptimizationLevelFromChar(char level);
+
+		// every module owns its context so modules can be optimized and emitted on separate threads
+		struct ModuleData
+		{
+			std::unique_ptr<llvm::LLVMContext> Context;
+			std::unique_ptr<llvm::Module>      Module;
+			std::unique_ptr<llvm::IRBuilder<>> Builder;
+		};
+
 		class Backend
 		{
 		public:
 			static void Init();
 			static void Shutdown();
 
-			static void BuildModule();
-			
-			static const auto& GetBuilder() { return s_Builder; }
-			static const auto& GetModule()  { return s_Module; }
-			static const auto& GetContext() { return s_Context; }
+			// creates a new context/module pair and makes it the current module, returns its index
+			static size_t CreateModule(const std::string& name);
+			static void SetCurrentModule(size_t index);
+
+			static size_t GetModuleCount()   { return s_Modules.size(); }
+			static size_t GetCurrentModule() { return s_CurrentModule; }
+
+			// emits the current module to options.OutputPath, when split the parts are written next to it
+			// as <output>.<part>.o and archived into options.OutputPath with a .a extension
+			static void BuildModule(const BuildOptions& options = {});
+
+			// optimizes and emits every module on a pool of worker threads, objects are written next to
+			// options.OutputPath as <module name>.o and then archived into options.OutputPath with a .a extension
+			static void BuildModules(const BuildOptions& options = {});
+
+			// JIT compiles every module in process and calls main, the modules and contexts are consumed
+			static int RunModule(const BuildOptions& options = {});
+
+			static const auto& GetBuilder() { return s_Modules[s_CurrentModule].Builder; }
+			static const auto& GetModule()  { return s_Modules[s_CurrentModule].Module; }
+			static const auto& GetContext() { return s_Modules[s_CurrentModule].Context; }
+
+		private:
+			static std::unique_ptr<llvm::TargetMachine> _CreateTargetMachine(const BuildOptions& options);
+			static void _RunOptimizationPipeline(llvm::Module& module, llvm::TargetMachine* targetMachine, const BuildOptions& options);
+			static void _EmitObject(llvm::Module& module, llvm::TargetMachine* targetMachine, const std::filesystem::path& path);
+			static void _WriteArchive(const std::vector<std::filesystem::path>& objects, const std::filesystem::path& archive, const std::string& targetTriple);
 
 		private:
-			inline static std::shared_ptr<llvm::LLVMContext> s_Context;
-			inline static std::shared_ptr<llvm::Module>      s_Module;
-			inline static std::shared_ptr<llvm::IRBuilder<>> s_Builder;
+			inline static std::vector<ModuleData> s_Modules;
+			inline static size_t s_CurrentModule = 0;
 		};
 
 	}
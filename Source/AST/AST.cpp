@@ -1,27 +1,169 @@
 #include "AST.h"
 
+#include "Parsing/TokenStream.h"
 #include "API/LLVM/LLVMBackend.h"
 #include "Core/Log.h"
+#include "Core/Profiler.h"
 
 #include <iostream>
+#include <algorithm>
 
 namespace clear {
 
-	AST::AST(const ProgramInfo& info)
+	namespace {
+
+		// gives a program that was lexed up front the interface of a TokenStream. it also keeps the range of tokens
+		// read since the last top level node, which is what an incremental rebuild compares against the edit
+		struct ProgramTokens
+		{
+			const ProgramInfo& Info;
+
+			size_t FirstRead = SIZE_MAX;
+			size_t LastRead = 0;
+
+			const Token& operator[](size_t index)
+			{
+				FirstRead = std::min(FirstRead, index);
+				LastRead = std::max(LastRead, index);
+				return Info.Tokens[index];
+			}
+
+			bool Contains(size_t index) const { return index < Info.Tokens.size(); }
+			void Release(size_t) const {}
+			std::string_view GetData(const Token& token) const { return Info.GetData(token); }
+			NumberLiteral GetLiteral(const Token& token) const { return Info.GetLiteral(token); }
+		};
+
+	}
+
+	AST::AST(const ProgramInfo& info, const std::string& rootName)
 	{
-		auto& tokens = info.Tokens;
-		auto& builder = *LLVM::Backend::GetBuilder();
+		CLEAR_PROFILE_SCOPE("AST::AST");
+
+		_CreateRoot(rootName);
+
+		ProgramTokens tokens{ info };
+		_Build(tokens, 0);
+	}
+
+	AST::AST(TokenStream& stream, const std::string& rootName)
+	{
+		CLEAR_PROFILE_SCOPE("AST::AST");
+
+		_CreateRoot(rootName);
+		_Build(stream, 0);
+	}
+
+	AST::AST(const ProgramInfo& info, const AST& previous, const TokenEdit& edit, const std::string& rootName)
+	{
+		CLEAR_PROFILE_SCOPE("AST::Update");
+
+		_CreateRoot(rootName);
+
+		ProgramTokens tokens{ info };
+
+		// node names start with the root's, nothing can be reused under another one
+		if (!previous.m_Root || previous.m_Root->GetName() != Symbol(rootName))
+		{
+			_Build(tokens, 0);
+			return;
+		}
+
+		// nodes built only from tokens in front of the edit are the same as before
+		size_t start = 0;
+
+		for (const TopLevelNode& node : previous.m_TopLevel)
+		{
+			if (node.LastRead >= edit.First)
+				break;
+
+			m_Arena->Retain(node.Owner);
+			m_Root->PushChild(node.Node);
+			m_TopLevel.push_back(node);
+			start = node.Next;
+		}
+
+		_Build(tokens, start, &previous, &edit);
+	}
+
+	AST::AST(BinaryReader& reader, const std::string& rootName)
+	{
+		CLEAR_PROFILE_SCOPE("AST::Deserialize");
+
+		_CreateRoot(rootName);
+
+		const uint32_t children = reader.Read<uint32_t>();
+
+		for (uint32_t i = 0; i < children; i++)
+			m_Root->PushChild(ASTNodeBase::Deserialize(reader, *m_Arena));
+	}
+
+	void AST::Serialize(BinaryWriter& writer) const
+	{
+		CLEAR_PROFILE_SCOPE("AST::Serialize");
+
+		// the root is made again from the name it's read back under
+		const auto& children = m_Root->GetChildren();
+		writer.Write<uint32_t>((uint32_t)children.size());
 
+		for (const auto& child : children)
+			child->Serialize(writer);
+	}
+
+	void AST::_CreateRoot(const std::string& rootName)
+	{
 		//possibly add command line arguments in the future
-		std::vector<Paramater> Paramaters;
+		std::vector<Paramater> paramaters;
 
-		m_Root = Ref<ASTFunctionDecleration>::Create("main", VariableType::None, Paramaters);
+		m_Root = Ref<ASTFunctionDecleration>::CreateIn(*m_Arena, Symbol(rootName), VariableType::None, paramaters);
 		m_Stack.push(m_Root);
+	}
+
+	bool AST::_ReuseTail(const AST& previous, const TokenEdit& edit, size_t next)
+	{
+		// past the edit (and the two tokens looked back at) building goes the same way it did before once it
+		// continues from a token it continued from before
+		if (next < edit.NewEnd + 2)
+			return false;
+
+		const size_t previousNext = next - edit.NewEnd + edit.OldEnd;
+		const std::vector<TopLevelNode>& nodes = previous.m_TopLevel;
+
+		auto it = std::lower_bound(nodes.begin(), nodes.end(), previousNext,
+			[](const TopLevelNode& node, size_t next) { return node.Next < next; });
 
-		for (size_t i = 0; i < tokens.size(); i++)
+		if (it == nodes.end() || it->Next != previousNext)
+			return false;
+
+		for (it++; it != nodes.end(); it++)
 		{
+			TopLevelNode node = *it;
+			node.FirstRead = node.FirstRead - edit.OldEnd + edit.NewEnd;
+			node.LastRead = node.LastRead - edit.OldEnd + edit.NewEnd;
+			node.Next = node.Next - edit.OldEnd + edit.NewEnd;
+
+			m_Arena->Retain(node.Owner);
+			m_Root->PushChild(node.Node);
+			m_TopLevel.push_back(node);
+		}
+
+		return true;
+	}
+
+	template<typename Tokens>
+	void AST::_Build(Tokens& tokens, size_t start, const AST* previous, const TokenEdit* edit)
+	{
+		auto& builder = *LLVM::Backend::GetBuilder();
+
+		std::vector<Paramater> Paramaters;
+
+		for (size_t i = start; tokens.Contains(i); i++)
+		{
+			// nothing looks further back than two tokens
+			tokens.Release(i - std::min<size_t>(i, 2));
+
 			auto& currentRoot =m_Stack.top();
-			auto& currentToken = tokens[i];
+			const Token currentToken = tokens[i];
 			auto& currentChildren = currentRoot->GetChildren();
 
 			switch (currentToken.TokenType)
@@ -32,7 +174,7 @@ namespace clear {
 					Paramaters.clear();
 
 					i++;
-					std::string name = tokens[i].Data;
+					const Symbol name(tokens.GetData(tokens[i]));
 
 					i++;
 					if (tokens[i].TokenType != TokenType::StartFunctionParameters)
@@ -50,14 +192,23 @@ namespace clear {
 						}
 						else
 						{
-							currentParamater.Name = tokens[i].Data;
+							currentParamater.Name = Symbol(tokens.GetData(tokens[i]));
 							Paramaters.push_back(currentParamater);
 						}
 
 						i++;
 					}
 
-					Ref<ASTFunctionDecleration> funcDec = Ref<ASTFunctionDecleration>::Create(name, returnType, Paramaters);
+					// an arrow after the paramaters is followed by the return type
+					if (tokens.Contains(i + 3) && tokens[i + 1].TokenType == TokenType::Arrow)
+					{
+						i += 3;
+
+						returnType = GetVariableTypeFromTokenType(tokens[i].TokenType);
+						CLEAR_VERIFY(returnType != VariableType::None, "unsupported return type");
+					}
+
+					Ref<ASTFunctionDecleration> funcDec = Ref<ASTFunctionDecleration>::CreateIn(*m_Arena, name, returnType, Paramaters);
 					currentRoot->PushChild(funcDec);
 					m_Stack.push(funcDec);
 
@@ -65,7 +216,7 @@ namespace clear {
 				}
 				case TokenType::FunctionCall:
 				{
-					const std::string& name = tokens[i].Data;
+					const Symbol name(tokens.GetData(tokens[i]));
 					std::vector<Argument> args;
 
 					i++;
@@ -88,8 +239,12 @@ namespace clear {
 							case TokenType::RValueNumber:
 							case TokenType::BooleanData:
 							{
-								arg.Field = AbstractType(tokens[i].Data);
-								arg.Data = tokens[i].Data;
+								if (tokens[i].TokenType == TokenType::RValueNumber)
+									arg.Value = tokens.GetLiteral(tokens[i]);
+								else
+									arg.Value = DecodeBoolLiteral(tokens.GetData(tokens[i]));
+
+								arg.Field = AbstractType(arg.Value);
 
 								args.push_back(arg);
 
@@ -98,7 +253,7 @@ namespace clear {
 							case TokenType::VariableReference:
 							{
 								arg.Field = AbstractType(tokens[i], TypeKind::Variable);
-								arg.Data = currentRoot->GetName() + "::" + tokens[i].Data;
+								arg.Variable = Symbol(currentRoot->GetName(), Symbol(tokens.GetData(tokens[i])));
 
 								args.push_back(arg);
 
@@ -114,21 +269,21 @@ namespace clear {
 						i++;
 					}
 
-					currentRoot->PushChild(Ref<ASTFunctionCall>::Create(name, args));
+					currentRoot->PushChild(Ref<ASTFunctionCall>::CreateIn(*m_Arena, name, args));
 					break;
 				}
 				case TokenType::VariableName:
 				{
-					auto& previous = tokens[i - 1];
+					const Token previous = tokens[i - 1];
 
 					AbstractType type;
 
 					if (previous.TokenType == TokenType::VariableReference)
-						type = AbstractType(VariableType::UserDefinedType, TypeKind::Variable, previous.Data);
+						type = AbstractType(VariableType::UserDefinedType, TypeKind::Variable, std::string(tokens.GetData(previous)));
 					else
 						type = AbstractType(previous, TypeKind::Variable);
 
-					currentRoot->PushChild(Ref<ASTVariableDecleration>::Create( currentRoot->GetName() + "::" + currentToken.Data, type));
+					currentRoot->PushChild(Ref<ASTVariableDecleration>::CreateIn(*m_Arena, Symbol(currentRoot->GetName(), Symbol(tokens.GetData(currentToken))), type));
 					break;
 				}
 				case TokenType::Struct:
@@ -137,7 +292,7 @@ namespace clear {
 
 					CLEAR_VERIFY(tokens[i].TokenType == TokenType::StructName, "invalid token after struct");
 					
-					const std::string& structName = tokens[i].Data;
+					std::string structName(tokens.GetData(tokens[i]));
 					
 					while (tokens[i].TokenType != TokenType::StartIndentation)
 						i++;
@@ -148,13 +303,13 @@ namespace clear {
 
 					while (tokens[i].TokenType == TokenType::VariableReference ||
 						   GetVariableTypeFromTokenType(tokens[i].TokenType) != VariableType::None &&
-						   i < tokens.size())
+						   tokens.Contains(i))
 					{
 						Member member;
 
 						if (tokens[i].TokenType == TokenType::VariableReference)
 						{
-							member.Field = AbstractType(VariableType::UserDefinedType, TypeKind::Variable, tokens[i].Data);
+							member.Field = AbstractType(VariableType::UserDefinedType, TypeKind::Variable, std::string(tokens.GetData(tokens[i])));
 						}
 						else
 						{
@@ -162,13 +317,13 @@ namespace clear {
 						}
 
 						i++;
-						member.Name = tokens[i].Data;
+						member.Name = tokens.GetData(tokens[i]);
 						memberVars.push_back(member);
 
 						i++;
 					}
 
-					currentRoot->PushChild(Ref<ASTStruct>::Create(structName, memberVars));
+					currentRoot->PushChild(Ref<ASTStruct>::CreateIn(*m_Arena, structName, memberVars));
 					break;
 				}
 				case TokenType::AddOp:
@@ -178,18 +333,30 @@ namespace clear {
 					break;
 				case TokenType::Assignment:
 				{
-					auto& previous = tokens[i - 1];
-					auto& assignmentType = tokens[i - 2];
+					const Token previous = tokens[i - 1];
+					const Token assignmentType = tokens[i - 2];
 					AbstractType type(assignmentType);
 
-					Ref<ASTBinaryExpression> binaryExpression = Ref<ASTBinaryExpression>::Create(BinaryExpressionType::Assignment, type);
+					Ref<ASTBinaryExpression> binaryExpression = Ref<ASTBinaryExpression>::CreateIn(*m_Arena, BinaryExpressionType::Assignment, type);
 					binaryExpression->PushChild(_CreateExpression(tokens, currentRoot->GetName(), i, type));
-					binaryExpression->PushChild(Ref<ASTVariableExpression>::Create(currentRoot->GetName() + "::" + previous.Data));
+					binaryExpression->PushChild(Ref<ASTVariableExpression>::CreateIn(*m_Arena, Symbol(currentRoot->GetName(), Symbol(tokens.GetData(previous)))));
 
 					currentRoot->PushChild(binaryExpression);
 
 					break;
 				}
+				case TokenType::Return:
+				{
+					const AbstractType returnType(currentRoot->GetReturnType());
+
+					Ref<ASTReturnStatement> returnStatement = Ref<ASTReturnStatement>::CreateIn(*m_Arena, returnType);
+
+					if (tokens.Contains(i + 1) && tokens[i + 1].TokenType != TokenType::EndLine)
+						returnStatement->PushChild(_CreateExpression(tokens, currentRoot->GetName(), i, returnType));
+
+					currentRoot->PushChild(returnStatement);
+					break;
+				}
 				case TokenType::EndIndentation:
 				{
 					if (m_Stack.size() > 1)
@@ -202,6 +369,22 @@ namespace clear {
 				default:
 					break;
 			}
+
+			// a streamed program can't be updated, so only nodes built from a whole program are recorded
+			if constexpr (std::is_same_v<Tokens, ProgramTokens>)
+			{
+				// a node under the root is complete once building is back at the root
+				if (m_Stack.size() == 1 && m_Root->GetChildren().size() > m_TopLevel.size())
+				{
+					m_TopLevel.push_back({ m_Arena, m_Root->GetChildren().back(), tokens.FirstRead, tokens.LastRead, i + 1 });
+
+					tokens.FirstRead = SIZE_MAX;
+					tokens.LastRead = 0;
+
+					if (previous && _ReuseTail(*previous, *edit, i + 1))
+						return;
+				}
+			}
 		}
 	}
 	void AST::BuildIR(const std::filesystem::path& out)
@@ -214,21 +397,35 @@ namespace clear {
 
 		auto& module = *LLVM::Backend::GetModule();
 
+		{
+			CLEAR_PROFILE_SCOPE("AST::Codegen");
+
+			ResetCodegenState();
+			m_Root->Codegen();
+		}
+
+		if (out.empty())
+			return;
+
+		CLEAR_PROFILE_SCOPE("AST::PrintIR");
+
 		std::error_code EC;
 		llvm::raw_fd_stream stream(out.string(), EC);
 
-		m_Root->Codegen();
-
 		module.print(stream, nullptr);
 	}
-	Ref<ASTExpression> AST::_CreateExpression(const std::vector<Token>& tokens, const std::string& root,
+	template<typename Tokens>
+	Ref<ASTExpression> AST::_CreateExpression(Tokens& tokens, Symbol root,
 											  size_t& start, AbstractType expectedType)
 	{
-		Ref<ASTExpression> expression = Ref<ASTExpression>::Create();
+		Ref<ASTExpression> expression = Ref<ASTExpression>::CreateIn(*m_Arena);
 		start += 1;
 
 		std::stack<Token> operators;
 
+		// the trees built so far, an operator takes the last two as its operands
+		std::vector<Ref<ASTNodeBase>> operands;
+
 		static std::map<TokenType, int> s_Presedence = {
 			{TokenType::DivOp, 2},
 			{TokenType::MulOp, 2},
@@ -237,17 +434,34 @@ namespace clear {
 			{TokenType::OpenBracket, 0}
 		};
 
-		while (start < tokens.size() && tokens[start].TokenType != TokenType::EndLine && tokens[start].TokenType != TokenType::EndIndentation)
+		auto applyOperator = [&]()
+			{
+				CLEAR_VERIFY(operands.size() >= 2, "operator is missing an operand");
+
+				Ref<ASTBinaryExpression> binaryExpression = Ref<ASTBinaryExpression>::CreateIn(*m_Arena, GetBinaryExpressionTypeFromTokenType(operators.top().TokenType), expectedType);
+				operators.pop();
+
+				// the right operand first, codegen reads the left one from the second child
+				binaryExpression->PushChild(operands.back());
+				operands.pop_back();
+
+				binaryExpression->PushChild(operands.back());
+				operands.pop_back();
+
+				operands.push_back(binaryExpression);
+			};
+
+		while (tokens.Contains(start) && tokens[start].TokenType != TokenType::EndLine && tokens[start].TokenType != TokenType::EndIndentation)
 		{
-			auto& token = tokens[start];
+			const Token token = tokens[start];
 
 			if (token.TokenType == TokenType::VariableReference)
 			{
-				expression->PushChild(Ref<ASTVariableExpression>::Create(root + "::" + token.Data));
+				operands.push_back(Ref<ASTVariableExpression>::CreateIn(*m_Arena, Symbol(root, Symbol(tokens.GetData(token)))));
 			}
 			else if (token.TokenType == TokenType::RValueNumber)
 			{
-				expression->PushChild(Ref<ASTNodeLiteral>::Create(token.Data));
+				operands.push_back(Ref<ASTNodeLiteral>::CreateIn(*m_Arena, tokens.GetLiteral(token)));
 			}
 			else if (token.TokenType == TokenType::OpenBracket)
 			{
@@ -256,10 +470,7 @@ namespace clear {
 			else if (token.TokenType == TokenType::CloseBracket)
 			{
 				while (!operators.empty() && operators.top().TokenType != TokenType::OpenBracket)
-				{
-					expression->PushChild(Ref<ASTBinaryExpression>::Create(GetBinaryExpressionTypeFromTokenType(operators.top().TokenType), expectedType));
-					operators.pop();
-				}
+					applyOperator();
 
 				if (!operators.empty())
 					operators.pop();
@@ -269,8 +480,7 @@ namespace clear {
 				while (!operators.empty() && operators.top().TokenType != TokenType::OpenBracket &&
 					s_Presedence[token.TokenType] <= s_Presedence[operators.top().TokenType])
 				{
-					expression->PushChild(Ref<ASTBinaryExpression>::Create(GetBinaryExpressionTypeFromTokenType(operators.top().TokenType), expectedType));
-					operators.pop();
+					applyOperator();
 				}
 
 				operators.push(token);
@@ -282,10 +492,10 @@ namespace clear {
 		start--;
 
 		while (!operators.empty())
-		{
-			expression->PushChild(Ref<ASTBinaryExpression>::Create(GetBinaryExpressionTypeFromTokenType(operators.top().TokenType), expectedType));
-			operators.pop();
-		}
+			applyOperator();
+
+		for (const auto& operand : operands)
+			expression->PushChild(operand);
 
 		return expression;
 	}
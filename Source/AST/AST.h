@@ -6,24 +6,65 @@
 
 #include <filesystem>
 #include <stack>
+#include <memory>
 
 namespace clear {
 
     class AST
     {
     public:
-        AST(const ProgramInfo& info);
+        // top level code is generated into a function called rootName
+        AST(const ProgramInfo& info, const std::string& rootName = "main");
+
+        // builds while the stream is still being lexed, only a window of tokens is held at once
+        AST(TokenStream& stream, const std::string& rootName = "main");
+
+        // builds the ast of info after an incremental update, the top level functions, structs and statements
+        // whose tokens the edit didn't touch are taken from previous instead of being built again
+        AST(const ProgramInfo& info, const AST& previous, const TokenEdit& edit, const std::string& rootName = "main");
+
+        // reads back what Serialize wrote, names were prefixed with the root name it was built under
+        AST(BinaryReader& reader, const std::string& rootName = "main");
         ~AST() = default;
 
-        void BuildIR(const std::filesystem::path& out);
+        // generates the module, the textual ir is also written to out when a path is given
+        void BuildIR(const std::filesystem::path& out = {});
+
+        void Serialize(BinaryWriter& writer) const;
+
+        // bytes of the nodes built for this ast, nodes taken from a previous ast are counted there
+        inline size_t GetMemoryUsage() const { return m_Arena->GetBytesUsed(); }
 
     private:
-        Ref<ASTExpression> _CreateExpression(const std::vector<Token>& tokens, const std::string& root,
+        void _CreateRoot(const std::string& rootName);
+        bool _ReuseTail(const AST& previous, const TokenEdit& edit, size_t next);
+
+        // Tokens is a ProgramInfo wrapper or a TokenStream, both are only instantiated in AST.cpp
+        template<typename Tokens>
+        void _Build(Tokens& tokens, size_t start, const AST* previous = nullptr, const TokenEdit* edit = nullptr);
+
+        template<typename Tokens>
+        Ref<ASTExpression> _CreateExpression(Tokens& tokens, Symbol root,
                                              size_t& start, AbstractType expectedType);
 
     private:
+        // a node directly under the root and the tokens it was built from
+        struct TopLevelNode
+        {
+            std::shared_ptr<Arena> Owner; // the arena the node was built in
+            Ref<ASTNodeBase> Node;
+            size_t FirstRead = 0;
+            size_t LastRead = 0;
+            size_t Next = 0; // the token building continued from
+        };
+
+    private:
+        // every node is made in here and freed with it, declared first so the nodes outlive the refs below
+        std::shared_ptr<Arena> m_Arena = std::make_shared<Arena>();
+
         Ref<ASTFunctionDecleration> m_Root;
         std::stack<Ref<ASTFunctionDecleration>> m_Stack;
+        std::vector<TopLevelNode> m_TopLevel;
     };
 
 }
\ No newline at end of file
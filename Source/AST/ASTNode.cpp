@@ -3,17 +3,26 @@
 #include "API/LLVM/LLVMBackend.h"
 #include "Core/Log.h"
 #include "Core/Types.h"
+#include "Core/Profiler.h"
 
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <stack>
 
 namespace clear {
 
-	static std::map<std::string, llvm::AllocaInst*>     s_VariableMap;
-	static std::map<std::string, ObjectReferenceInfo>   s_StructTypes;
-	static std::stack<llvm::IRBuilderBase::InsertPoint> s_InsertPoints;
-	static std::map<std::string, std::vector<Paramater>> s_FunctionToExpectedTypes;
+	static std::unordered_map<Symbol, llvm::AllocaInst*>           s_VariableMap;
+	static std::map<std::string, ObjectReferenceInfo>             s_StructTypes;
+	static std::stack<llvm::IRBuilderBase::InsertPoint>           s_InsertPoints;
+	static std::unordered_map<Symbol, std::vector<Paramater>>     s_FunctionToExpectedTypes;
+
+	void ResetCodegenState()
+	{
+		s_VariableMap.clear();
+		s_StructTypes.clear();
+		s_InsertPoints = {};
+	}
 
 	llvm::Value* ASTNodeBase::Codegen()
 	{
@@ -43,24 +52,166 @@ namespace clear {
 	{
 		m_Parent.Reset();
 	}
-	ASTNodeLiteral::ASTNodeLiteral(const std::string& data)
-		: m_Data(data), m_Type(data)
+
+	static void WriteType(BinaryWriter& writer, const AbstractType& type)
+	{
+		writer.Write(type.Get());
+		writer.Write(type.GetKind());
+		writer.WriteString(type.GetUserDefinedType());
+	}
+
+	static AbstractType ReadType(BinaryReader& reader)
+	{
+		const VariableType type = reader.Read<VariableType>();
+		const TypeKind kind = reader.Read<TypeKind>();
+
+		return AbstractType(type, kind, std::string(reader.ReadString()));
+	}
+
+	void ASTNodeBase::Serialize(BinaryWriter& writer) const
+	{
+		writer.Write(GetType());
+		_SerializeFields(writer);
+
+		writer.Write<uint32_t>((uint32_t)m_Children.size());
+
+		for (auto& child : m_Children)
+			child->Serialize(writer);
+	}
+
+	Ref<ASTNodeBase> ASTNodeBase::Deserialize(BinaryReader& reader, Arena& arena)
+	{
+		Ref<ASTNodeBase> node;
+
+		const ASTNodeType type = reader.Read<ASTNodeType>();
+
+		switch (type)
+		{
+			case ASTNodeType::Base:
+			{
+				node = Ref<ASTNodeBase>::CreateIn(arena);
+				break;
+			}
+			case ASTNodeType::Literal:
+			{
+				node = Ref<ASTNodeLiteral>::CreateIn(arena, reader.Read<NumberLiteral>());
+				break;
+			}
+			case ASTNodeType::BinaryExpression:
+			{
+				const BinaryExpressionType expression = reader.Read<BinaryExpressionType>();
+				node = Ref<ASTBinaryExpression>::CreateIn(arena, expression, ReadType(reader));
+				break;
+			}
+			case ASTNodeType::VariableExpression:
+			{
+				node = Ref<ASTVariableExpression>::CreateIn(arena, Symbol(reader.ReadString()));
+				break;
+			}
+			case ASTNodeType::VariableDecleration:
+			{
+				const Symbol name(reader.ReadString());
+				node = Ref<ASTVariableDecleration>::CreateIn(arena, name, ReadType(reader));
+				break;
+			}
+			case ASTNodeType::FunctionDecleration:
+			{
+				const Symbol name(reader.ReadString());
+				const VariableType returnType = reader.Read<VariableType>();
+
+				std::vector<Paramater> paramaters(reader.Read<uint32_t>());
+
+				for (Paramater& paramater : paramaters)
+				{
+					paramater.Name = Symbol(reader.ReadString());
+					paramater.Type = ReadType(reader);
+				}
+
+				node = Ref<ASTFunctionDecleration>::CreateIn(arena, name, returnType, paramaters);
+				break;
+			}
+			case ASTNodeType::ReturnStatement:
+			{
+				node = Ref<ASTReturnStatement>::CreateIn(arena, ReadType(reader));
+				break;
+			}
+			case ASTNodeType::Expression:
+			{
+				node = Ref<ASTExpression>::CreateIn(arena);
+				break;
+			}
+			case ASTNodeType::Struct:
+			{
+				std::string name(reader.ReadString());
+				std::vector<Member> members(reader.Read<uint32_t>());
+
+				for (Member& member : members)
+				{
+					member.Field = ReadType(reader);
+					member.Name = reader.ReadString();
+				}
+
+				node = Ref<ASTStruct>::CreateIn(arena, name, members);
+				break;
+			}
+			case ASTNodeType::FunctionCall:
+			{
+				const Symbol name(reader.ReadString());
+				std::vector<Argument> arguments(reader.Read<uint32_t>());
+
+				for (Argument& argument : arguments)
+				{
+					argument.Field = ReadType(reader);
+					argument.Value = reader.Read<NumberLiteral>();
+					argument.Variable = Symbol(reader.ReadString());
+				}
+
+				node = Ref<ASTFunctionCall>::CreateIn(arena, name, arguments);
+				break;
+			}
+			default:
+			{
+				CLEAR_ANNOTATED_HALT("unknown serialized node type ", (int)type);
+				break;
+			}
+		}
+
+		const uint32_t children = reader.Read<uint32_t>();
+
+		for (uint32_t i = 0; i < children; i++)
+			node->PushChild(Deserialize(reader, arena));
+
+		return node;
+	}
+	ASTNodeLiteral::ASTNodeLiteral(const NumberLiteral& value)
+		: ASTNodeBase(ASTNodeType::Literal), m_Value(value), m_Type(value)
 	{
 	}
 
+	void ASTNodeLiteral::_SerializeFields(BinaryWriter& writer) const
+	{
+		writer.Write(m_Value);
+	}
+
 	llvm::Value* ASTNodeLiteral::Codegen()
 	{
-		return GetLLVMConstant(m_Type, m_Data);
+		return GetLLVMConstant(m_Type, m_Value);
 	}
 
 	ASTBinaryExpression::ASTBinaryExpression(BinaryExpressionType type, AbstractType expectedType)
-		: m_Expression(type), m_ExpectedType(expectedType)
+		: ASTNodeBase(ASTNodeType::BinaryExpression), m_Expression(type), m_ExpectedType(expectedType)
+	{
+	}
+
+	void ASTBinaryExpression::_SerializeFields(BinaryWriter& writer) const
 	{
+		writer.Write(m_Expression);
+		WriteType(writer, m_ExpectedType);
 	}
+
 	llvm::Value* ASTBinaryExpression::Codegen()
 	{
 		// Assumes the two values in its children are to be added in order
-		auto& builder = *LLVM::Backend::GetBuilder();
 		auto& children = GetChildren();
 
 		if (children.size() != 2)
@@ -69,6 +220,13 @@ namespace clear {
 		llvm::Value* LHS = children[1]->Codegen();
 		llvm::Value* RHS = children[0]->Codegen();
 
+		return Emit(m_Expression, m_ExpectedType, LHS, RHS);
+	}
+
+	llvm::Value* ASTBinaryExpression::Emit(BinaryExpressionType expression, const AbstractType& expectedType, llvm::Value* LHS, llvm::Value* RHS)
+	{
+		auto& builder = *LLVM::Backend::GetBuilder();
+
 		CLEAR_VERIFY(LHS && RHS, "lhs or rhs failed to generate");
 
 		llvm::Value* LHSRawValue = LHS;
@@ -81,19 +239,19 @@ namespace clear {
 		}
 
 		// Load values if they are alloca instructions
-		if (llvm::isa<llvm::AllocaInst>(LHS) && m_Expression != BinaryExpressionType::Assignment)
+		if (llvm::isa<llvm::AllocaInst>(LHS) && expression != BinaryExpressionType::Assignment)
 		{
 			auto converted = llvm::dyn_cast<llvm::AllocaInst>(LHS);
 			LHSRawValue = builder.CreateLoad(converted->getAllocatedType(), LHS);
 		}
-		else if (llvm::isa<llvm::AllocaInst>(LHS) && m_Expression == BinaryExpressionType::Assignment)
+		else if (llvm::isa<llvm::AllocaInst>(LHS) && expression == BinaryExpressionType::Assignment)
 		{
-			return _CreateExpression(LHS, RHS, LHSRawValue, RHSRawValue);
+			return _CreateExpression(expression, LHS, RHS, LHSRawValue, RHSRawValue);
 		}
 
-		llvm::Type* expectedLLVMType = m_ExpectedType.GetLLVMType(); 
+		llvm::Type* expectedLLVMType = expectedType.GetLLVMType(); 
 
-		switch (m_ExpectedType.Get())
+		switch (expectedType.Get())
 		{
 			case VariableType::Int8:
 			case VariableType::Int16:
@@ -105,29 +263,29 @@ namespace clear {
 			case VariableType::Uint64:
 			{
 				if (LHSRawValue->getType() != expectedLLVMType)
-					LHSRawValue = AbstractType::CastValue(LHSRawValue, m_ExpectedType);
+					LHSRawValue = AbstractType::CastValue(LHSRawValue, expectedType);
 
 				if (RHSRawValue->getType() != expectedLLVMType)
-					RHSRawValue = AbstractType::CastValue(RHSRawValue, m_ExpectedType);
+					RHSRawValue = AbstractType::CastValue(RHSRawValue, expectedType);
 				break;
 			}
 			case VariableType::Float32:
 			case VariableType::Float64:
 			{
 				if (LHSRawValue->getType() != expectedLLVMType)
-					LHSRawValue = AbstractType::CastValue(LHSRawValue, m_ExpectedType);
+					LHSRawValue = AbstractType::CastValue(LHSRawValue, expectedType);
 
 				if (RHSRawValue->getType() != expectedLLVMType)
-					RHSRawValue = AbstractType::CastValue(RHSRawValue, m_ExpectedType);
+					RHSRawValue = AbstractType::CastValue(RHSRawValue, expectedType);
 				break;
 			}
 			case VariableType::Bool:
 			{
 				if (LHSRawValue->getType() != expectedLLVMType)
-					LHSRawValue = AbstractType::CastValue(LHSRawValue, m_ExpectedType);
+					LHSRawValue = AbstractType::CastValue(LHSRawValue, expectedType);
 
 				if (RHSRawValue->getType() != expectedLLVMType)
-					RHSRawValue = AbstractType::CastValue(RHSRawValue, m_ExpectedType);
+					RHSRawValue = AbstractType::CastValue(RHSRawValue, expectedType);
 
 				break;
 			}
@@ -137,35 +295,35 @@ namespace clear {
 				break;
 		}
 
-		return _CreateExpression(LHS, RHS, LHSRawValue, RHSRawValue);
+		return _CreateExpression(expression, LHS, RHS, LHSRawValue, RHSRawValue);
 	}
 
-	const bool ASTBinaryExpression::_IsMathExpression() const
+	const bool ASTBinaryExpression::_IsMathExpression(BinaryExpressionType expression)
 	{
-		return (int)m_Expression <= (int)BinaryExpressionType::Mod;
+		return (int)expression <= (int)BinaryExpressionType::Mod;
 	}
 
-	const bool ASTBinaryExpression::_IsCmpExpression() const
+	const bool ASTBinaryExpression::_IsCmpExpression(BinaryExpressionType expression)
 	{
-		return (int)m_Expression <= (int)BinaryExpressionType::Eq && !_IsMathExpression();
+		return (int)expression <= (int)BinaryExpressionType::Eq && !_IsMathExpression(expression);
 	}
 
-	llvm::Value* ASTBinaryExpression::_CreateExpression(llvm::Value* LHS, llvm::Value* RHS, llvm::Value* LHSRawValue, llvm::Value* RHSRawValue)
+	llvm::Value* ASTBinaryExpression::_CreateExpression(BinaryExpressionType expression, llvm::Value* LHS, llvm::Value* RHS, llvm::Value* LHSRawValue, llvm::Value* RHSRawValue)
 	{
-		if (_IsMathExpression())
-			return _CreateMathExpression(LHSRawValue, RHSRawValue);
-		else if (_IsCmpExpression())
-			return _CreateCmpExpression(LHSRawValue, RHSRawValue);
+		if (_IsMathExpression(expression))
+			return _CreateMathExpression(expression, LHSRawValue, RHSRawValue);
+		else if (_IsCmpExpression(expression))
+			return _CreateCmpExpression(expression, LHSRawValue, RHSRawValue);
 		
-		return _CreateLoadStoreExpression(LHS, RHSRawValue);
+		return _CreateLoadStoreExpression(expression, LHS, RHSRawValue);
 	}
 
-	llvm::Value* ASTBinaryExpression::_CreateMathExpression(llvm::Value* LHS, llvm::Value* RHS)
+	llvm::Value* ASTBinaryExpression::_CreateMathExpression(BinaryExpressionType expression, llvm::Value* LHS, llvm::Value* RHS)
 	{
 		auto& builder = LLVM::Backend::GetBuilder();
 		const bool isFloat = LHS->getType()->isFloatingPointTy();
 
-		switch (m_Expression)
+		switch (expression)
 		{
 			case BinaryExpressionType::Add:
 				return isFloat ? builder->CreateFAdd(LHS, RHS, "faddtmp")
@@ -194,12 +352,12 @@ namespace clear {
 
 		return nullptr;
 	}
-	llvm::Value* ASTBinaryExpression::_CreateCmpExpression(llvm::Value* LHS, llvm::Value* RHS)
+	llvm::Value* ASTBinaryExpression::_CreateCmpExpression(BinaryExpressionType expression, llvm::Value* LHS, llvm::Value* RHS)
 	{
 		auto& builder = LLVM::Backend::GetBuilder();
 		const bool isFloat = LHS->getType()->isFloatingPointTy();
 
-		switch (m_Expression)
+		switch (expression)
 		{
 			case BinaryExpressionType::Less:
 				return isFloat ? builder->CreateFCmpOLT(LHS, RHS)
@@ -223,11 +381,11 @@ namespace clear {
 		return nullptr;
 	}
 
-	llvm::Value* ASTBinaryExpression::_CreateLoadStoreExpression(llvm::Value* LHS, llvm::Value* RHS)
+	llvm::Value* ASTBinaryExpression::_CreateLoadStoreExpression(BinaryExpressionType expression, llvm::Value* LHS, llvm::Value* RHS)
 	{
 		auto& builder = LLVM::Backend::GetBuilder();
 
-		switch (m_Expression)
+		switch (expression)
 		{
 			case BinaryExpressionType::Assignment:	return builder->CreateStore(RHS, LHS);
 				default:
@@ -237,70 +395,131 @@ namespace clear {
 		return nullptr;
 	}
 
-	ASTVariableExpression::ASTVariableExpression(const std::string& name)
-		: m_Name(name)
+	ASTVariableExpression::ASTVariableExpression(Symbol name)
+		: ASTNodeBase(ASTNodeType::VariableExpression), m_Name(name)
+	{
+	}
+
+	void ASTVariableExpression::_SerializeFields(BinaryWriter& writer) const
 	{
+		writer.WriteString(m_Name.GetString());
 	}
 
 	llvm::Value* ASTVariableExpression::Codegen()
 	{
-		if (!s_VariableMap.contains(m_Name))
+		return Emit(m_Name);
+	}
+
+	llvm::Value* ASTVariableExpression::Emit(Symbol name)
+	{
+		if (!s_VariableMap.contains(name))
 		{
-			std::cout << "no variable of name " << m_Name << " exists" << std::endl;
+			std::cout << "no variable of name " << name.GetString() << " exists" << std::endl;
 			return nullptr;
 		}
 
-		llvm::AllocaInst* value = s_VariableMap.at(m_Name);
+		llvm::AllocaInst* value = s_VariableMap.at(name);
 		CLEAR_VERIFY(value, "value was nullptr");
 
 		return value;
 	}
 
-	ASTVariableDecleration::ASTVariableDecleration(const std::string& name, AbstractType type)
-		: m_Name(name), m_Type(type)
+	ASTVariableDecleration::ASTVariableDecleration(Symbol name, AbstractType type)
+		: ASTNodeBase(ASTNodeType::VariableDecleration), m_Name(name), m_Type(type)
 	{
 	}
 
+	void ASTVariableDecleration::_SerializeFields(BinaryWriter& writer) const
+	{
+		writer.WriteString(m_Name.GetString());
+		WriteType(writer, m_Type);
+	}
+
 	llvm::Value* ASTVariableDecleration::Codegen()
 	{
-		if (s_VariableMap.contains(m_Name))
+		return Emit(m_Name, m_Type);
+	}
+
+	llvm::Value* ASTVariableDecleration::Emit(Symbol name, const AbstractType& type)
+	{
+		if (s_VariableMap.contains(name))
 		{
-			std::cout << "variable of the name " << m_Name << " exists" << std::endl;
+			std::cout << "variable of the name " << name.GetString() << " exists" << std::endl;
 			return nullptr;
 		}
 
 		auto& builder = *LLVM::Backend::GetBuilder();
 
-		if (m_Type.Get() == VariableType::UserDefinedType)
+		if (type.Get() == VariableType::UserDefinedType)
 		{
-			auto& structType = m_Type.GetUserDefinedType();
+			auto& structType = type.GetUserDefinedType();
 
-			auto value = builder.CreateAlloca(s_StructTypes[structType].Struct, nullptr, m_Name);
-			s_VariableMap[m_Name] = value;
+			auto value = builder.CreateAlloca(s_StructTypes[structType].Struct, nullptr, name.GetString());
+			s_VariableMap[name] = value;
 
 			return value;
 		}
 
-		auto variableType = m_Type.Get();
-		auto value = builder.CreateAlloca(GetLLVMVariableType(variableType), nullptr, m_Name);
-		s_VariableMap[m_Name] = value;
+		auto variableType = type.Get();
+		auto value = builder.CreateAlloca(GetLLVMVariableType(variableType), nullptr, name.GetString());
+		s_VariableMap[name] = value;
 		
 		return value;
 	}
 
-	ASTFunctionDecleration::ASTFunctionDecleration(const std::string& name, VariableType returnType, const std::vector<Paramater>& Paramaters)
-		: m_Name(name), m_ReturnType(returnType), m_Paramaters(Paramaters)
+	ASTFunctionDecleration::ASTFunctionDecleration(Symbol name, VariableType returnType, const std::vector<Paramater>& Paramaters)
+		: ASTNodeBase(ASTNodeType::FunctionDecleration), m_Name(name), m_ReturnType(returnType), m_Paramaters(Paramaters)
 	{
-		s_FunctionToExpectedTypes[m_Name] = m_Paramaters;
+		Declare(m_Name, m_Paramaters);
+	}
+
+	void ASTFunctionDecleration::Declare(Symbol name, const std::vector<Paramater>& paramaters)
+	{
+		s_FunctionToExpectedTypes[name] = paramaters;
+
+		static const Symbol s_Sleep("_sleep");
 
-		if (!s_FunctionToExpectedTypes.contains("_sleep")) //TODO: remove thhis immediately
+		if (!s_FunctionToExpectedTypes.contains(s_Sleep)) //TODO: remove thhis immediately
 		{
-			auto& e = s_FunctionToExpectedTypes["_sleep"];
-			e.push_back({ .Name = "time", .Type = AbstractType(VariableType::Int32) });
+			auto& e = s_FunctionToExpectedTypes[s_Sleep];
+			e.push_back({ .Name = Symbol("time"), .Type = AbstractType(VariableType::Int32) });
 		}
 
 	}
+
+	void ASTFunctionDecleration::_SerializeFields(BinaryWriter& writer) const
+	{
+		writer.WriteString(m_Name.GetString());
+		writer.Write(m_ReturnType);
+		writer.Write<uint32_t>((uint32_t)m_Paramaters.size());
+
+		for (const Paramater& paramater : m_Paramaters)
+		{
+			writer.WriteString(paramater.Name.GetString());
+			WriteType(writer, paramater.Type);
+		}
+	}
+
 	llvm::Value* ASTFunctionDecleration::Codegen()
+	{
+		CLEAR_PROFILE_DETAIL_SCOPE(m_Name.GetString());
+
+		llvm::Function* function = EmitBegin(m_Name, m_ReturnType, m_Paramaters);
+
+		for (const auto& child : GetChildren())
+		{
+			child->Codegen();
+
+			if (Isa<ASTReturnStatement>(child))
+				break;
+		}
+
+		EmitEnd(m_Name, m_ReturnType, m_Paramaters);
+
+		return function;
+	}
+
+	llvm::Function* ASTFunctionDecleration::EmitBegin(Symbol name, VariableType returnType, std::span<const Paramater> paramaters)
 	{
 		auto& module  = *LLVM::Backend::GetModule();
 		auto& context = *LLVM::Backend::GetContext();
@@ -308,26 +527,24 @@ namespace clear {
 
 		s_InsertPoints.push(builder.saveIP());
 
-		llvm::Type* returnType = GetLLVMVariableType(m_ReturnType);
-
 		std::vector<llvm::Type*> ParamaterTypes;
-		for (const auto& Paramater : m_Paramaters)
+		for (const auto& Paramater : paramaters)
 		{
 			ParamaterTypes.push_back(GetLLVMVariableType(Paramater.Type));
 		}
 
-		llvm::FunctionType* functionType = llvm::FunctionType::get(returnType, ParamaterTypes, false);
+		llvm::FunctionType* functionType = llvm::FunctionType::get(GetLLVMVariableType(returnType), ParamaterTypes, false);
 
-		llvm::Function* function = module.getFunction(m_Name);
+		llvm::Function* function = module.getFunction(name.GetString());
 		CLEAR_VERIFY(!function, "function already defined");
 
-		function = llvm::Function::Create(functionType, llvm::Function::ExternalLinkage, m_Name, module);
+		function = llvm::Function::Create(functionType, llvm::Function::ExternalLinkage, name.GetString(), module);
 
 		llvm::Function::arg_iterator args = function->arg_begin();
 
-		for (const auto& Paramater : m_Paramaters)
+		for (const auto& Paramater : paramaters)
 		{
-			args->setName(Paramater.Name);
+			args->setName(Paramater.Name.GetString());
 			args++;
 		}
 
@@ -335,28 +552,27 @@ namespace clear {
 		builder.SetInsertPoint(entry);
 
 		uint32_t k = 0;
-		for (const auto& Paramater : m_Paramaters)
+		for (const auto& Paramater : paramaters)
 		{
-			llvm::AllocaInst* argAlloc = builder.CreateAlloca(GetLLVMVariableType(Paramater.Type), nullptr, Paramater.Name);
+			llvm::AllocaInst* argAlloc = builder.CreateAlloca(GetLLVMVariableType(Paramater.Type), nullptr, Paramater.Name.GetString());
 			builder.CreateStore(function->getArg(k), argAlloc);
-			s_VariableMap[m_Name + "::" + Paramater.Name] = argAlloc;
+			s_VariableMap[Symbol(name, Paramater.Name)] = argAlloc;
 			k++;
 		}
 
-		for (const auto& child : GetChildren())
-		{
-			child->Codegen();
+		return function;
+	}
 
-			if (child->GetType() == ASTNodeType::ReturnStatement)
-				break;
-		}
+	void ASTFunctionDecleration::EmitEnd(Symbol name, VariableType returnType, std::span<const Paramater> paramaters)
+	{
+		auto& builder = *LLVM::Backend::GetBuilder();
 
-		for (const auto& Paramater : m_Paramaters)
+		for (const auto& Paramater : paramaters)
 		{
-			s_VariableMap.erase(m_Name + "::" + Paramater.Name);
+			s_VariableMap.erase(Symbol(name, Paramater.Name));
 		}
 
-		if (returnType->isVoidTy() && !builder.GetInsertBlock()->getTerminator())
+		if (GetLLVMVariableType(returnType)->isVoidTy() && !builder.GetInsertBlock()->getTerminator())
 		{
 			builder.CreateRetVoid();
 		}
@@ -364,65 +580,74 @@ namespace clear {
 		auto& ip = s_InsertPoints.top();
 		builder.restoreIP(ip);
 		s_InsertPoints.pop();
+	}
 
-		return function;
+	void ASTReturnStatement::_SerializeFields(BinaryWriter& writer) const
+	{
+		WriteType(writer, m_ReturnType);
 	}
 
 	llvm::Value* ASTReturnStatement::Codegen()
+	{
+		if (GetChildren().size() > 0 && m_ReturnType.Get() != VariableType::None)
+			return Emit(GetChildren()[0]->Codegen(), m_ReturnType);
+
+		return Emit(nullptr, m_ReturnType);
+	}
+
+	llvm::Value* ASTReturnStatement::Emit(llvm::Value* value, const AbstractType& returnType)
 	{
 		auto& builder = *LLVM::Backend::GetBuilder();
 
-		if (GetChildren().size() > 0)
-		{
-			llvm::Value* returnValue = GetChildren()[0]->Codegen();
-			return builder.CreateRet(returnValue);
-		}
+		if (!value || returnType.Get() == VariableType::None)
+			return builder.CreateRetVoid();
 
-		return builder.CreateRetVoid();
+		if (auto alloca = llvm::dyn_cast<llvm::AllocaInst>(value))
+			value = builder.CreateLoad(alloca->getAllocatedType(), alloca);
+
+		return builder.CreateRet(AbstractType::CastValue(value, returnType));
 	}
 	llvm::Value* ASTExpression::Codegen()
 	{
-		auto& builder  = *LLVM::Backend::GetBuilder();
 		auto& children = GetChildren();
 
-		std::stack<Ref<ASTNodeBase>> stack;
-
-		for (const auto& child : children)
-		{
-			if (child->GetType() == ASTNodeType::Literal ||
-				child->GetType() == ASTNodeType::VariableExpression)
-			{
-				stack.push(child);
-				continue;
-			}
+		// the operators already hold their operands. an expression the parser got wrong can be left with several
+		// trees, only the last one is its value
+		CLEAR_VERIFY(!children.empty(), "expression has no operands");
 
-			Ref<ASTBinaryExpression> binExp = ASTBinaryExpression::DynamicCast<ASTBinaryExpression>(child);
+		return children.back()->Codegen();
+	}
 
-			binExp->PushChild(stack.top());
-			stack.pop();
+	ASTStruct::ASTStruct(const std::string& name, const std::vector<Member>& fields)
+		: ASTNodeBase(ASTNodeType::Struct), m_Name(name), m_Members(fields)
+	{
+	}
 
-			binExp->PushChild(stack.top());
-			stack.pop();
+	void ASTStruct::_SerializeFields(BinaryWriter& writer) const
+	{
+		writer.WriteString(m_Name);
+		writer.Write<uint32_t>((uint32_t)m_Members.size());
 
-			stack.push(binExp);
+		for (const Member& member : m_Members)
+		{
+			WriteType(writer, member.Field);
+			writer.WriteString(member.Name);
 		}
-
-		return stack.top()->Codegen();
 	}
 
-	ASTStruct::ASTStruct(const std::string& name, const std::vector<Member>& fields)
-		: m_Name(name), m_Members(fields)
+	llvm::Value* ASTStruct::Codegen()
 	{
+		return Emit(m_Name, m_Members);
 	}
 
-	llvm::Value* ASTStruct::Codegen()
+	llvm::Value* ASTStruct::Emit(const std::string& name, std::span<const Member> members)
 	{
 		std::vector<llvm::Type*> types;
 
 		ObjectReferenceInfo info;
 		uint32_t k = 0;
 
-		for (auto& member : m_Members)
+		for (auto& member : members)
 		{
 			if (member.Field.Get() == VariableType::UserDefinedType)
 			{
@@ -441,32 +666,50 @@ namespace clear {
 		}
 
 		info.Struct = llvm::StructType::create(types);
-		s_StructTypes[m_Name] = info;
+		s_StructTypes[name] = info;
 
 		return nullptr;
 	}
 
-	ASTFunctionCall::ASTFunctionCall(const std::string& name, const std::vector<Argument>& arguments)
-		:  m_Name(name), m_Arguments(arguments)
+	ASTFunctionCall::ASTFunctionCall(Symbol name, const std::vector<Argument>& arguments)
+		: ASTNodeBase(ASTNodeType::FunctionCall), m_Name(name), m_Arguments(arguments)
 	{
 	}
 
+	void ASTFunctionCall::_SerializeFields(BinaryWriter& writer) const
+	{
+		writer.WriteString(m_Name.GetString());
+		writer.Write<uint32_t>((uint32_t)m_Arguments.size());
+
+		for (const Argument& argument : m_Arguments)
+		{
+			WriteType(writer, argument.Field);
+			writer.Write(argument.Value);
+			writer.WriteString(argument.Variable.GetString());
+		}
+	}
+
 	llvm::Value* ASTFunctionCall::Codegen()
+	{
+		return Emit(m_Name, m_Arguments);
+	}
+
+	llvm::Value* ASTFunctionCall::Emit(Symbol name, std::span<const Argument> arguments)
 	{
 		std::vector<llvm::Value*> args;
 
 		auto& builder = *LLVM::Backend::GetBuilder();
 		auto& module  = *LLVM::Backend::GetModule();
 
-		auto& expected = s_FunctionToExpectedTypes.at(m_Name);
+		auto& expected = s_FunctionToExpectedTypes.at(name);
 
 		uint32_t k = 0;
-		for (const auto& argument : m_Arguments)
+		for (const auto& argument : arguments)
 		{
 			if(argument.Field.GetKind() == TypeKind::RValue)
 			{
 				auto& variableType = argument.Field;
-				auto value = GetLLVMConstant(variableType, argument.Data);
+				auto value = GetLLVMConstant(variableType, argument.Value);
 
 				if (variableType.Get() != expected[k].Type.Get())
 					value = AbstractType::CastValue(value, expected[k].Type);
@@ -475,9 +718,8 @@ namespace clear {
 			}
 			else
 			{
-				auto& variableName = argument.Data;
 				auto& variableType = argument.Field;
-				auto& variable = s_VariableMap.at(variableName);
+				auto& variable = s_VariableMap.at(argument.Variable);
 
 				llvm::Value* value = builder.CreateLoad(variable->getAllocatedType(), variable);
 
@@ -490,7 +732,9 @@ namespace clear {
 		}
 
 
-		if (m_Name == "_sleep") 
+		const std::string_view calleeName = name.GetString();
+
+		if (calleeName == "_sleep") 
 		{
 			llvm::Function* sleepFunc = llvm::cast<llvm::Function>(
 				module.getOrInsertFunction("_sleep",
@@ -498,7 +742,7 @@ namespace clear {
 						llvm::Type::getInt32Ty(module.getContext()),
 						false)).getCallee());
 		}
-		else if (m_Name == "sleep")
+		else if (calleeName == "sleep")
 		{
 			llvm::Function* sleepFunc = llvm::cast<llvm::Function>(
 				module.getOrInsertFunction("sleep",
@@ -506,7 +750,7 @@ namespace clear {
 						llvm::Type::getInt32Ty(module.getContext()),
 						false)).getCallee());
 		}
-		else if (m_Name == "nanosleep")
+		else if (calleeName == "nanosleep")
 		{
 			llvm::Function* sleepFunc = llvm::cast<llvm::Function>(
 				module.getOrInsertFunction("nanosleep",
@@ -516,7 +760,7 @@ namespace clear {
 		}
 		
 
-		llvm::Function* callee = module.getFunction(m_Name);
+		llvm::Function* callee = module.getFunction(calleeName);
 		CLEAR_VERIFY(callee, "not a valid function");
 
 		return builder.CreateCall(callee, args);
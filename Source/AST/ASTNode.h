@@ -3,9 +3,12 @@
 #include "Parsing/Tokens.h"
 #include "Core/Types.h"
 #include "Core/Ref.h"
+#include "Core/Serialization.h"
+#include "Core/Symbol.h"
 
 #include <vector>
 #include <string>
+#include <span>
 
 
 
@@ -19,6 +22,10 @@ namespace clear {
 		Expression, Struct, FunctionCall
 	};
 
+	// codegen keeps variables and struct types between nodes, these belong to the current module's context
+	// so they have to be cleared before generating another module
+	extern void ResetCodegenState();
+
 
 	//
 	// ---------------------- BASE -----------------------
@@ -27,9 +34,14 @@ namespace clear {
 	class ASTNodeBase : public Ref<ASTNodeBase>
 	{
 	public:
-		ASTNodeBase() = default;
+		ASTNodeBase(ASTNodeType type = ASTNodeType::Base)
+			: m_Type(type) {}
 		virtual ~ASTNodeBase() = default;
-		virtual inline const ASTNodeType GetType() const { return ASTNodeType::Base; }
+
+		// set once by the constructor of the node's class, isa/cast/dyn_cast compare it through classof
+		inline const ASTNodeType GetType() const { return m_Type; }
+		static inline bool classof(const ASTNodeBase*) { return true; }
+
 		virtual llvm::Value* Codegen();
 
 		void PushChild(const Ref<ASTNodeBase>& child);
@@ -38,12 +50,20 @@ namespace clear {
 		void SetParent(const Ref<ASTNodeBase>& parent);
 		void RemoveParent();
 
-		const auto  GetParent()   const { return m_Parent; }
+		const auto  GetParent()   const { return m_Parent.Lock(); }
 		const auto& GetChildren() const { return m_Children; }
 
+		// writes the node and its children, reading them back builds the same tree through the node constructors
+		void Serialize(BinaryWriter& writer) const;
+		static Ref<ASTNodeBase> Deserialize(BinaryReader& reader, Arena& arena);
+
+	protected:
+		virtual void _SerializeFields(BinaryWriter&) const {}
+
 	private:
-		Ref<ASTNodeBase> m_Parent;
+		WeakRef<ASTNodeBase> m_Parent; // weak, the parent already holds its children
 		std::vector<Ref<ASTNodeBase>> m_Children;
+		ASTNodeType m_Type;
 	};
 	//
 	// -------------------------------------------------------
@@ -55,14 +75,17 @@ namespace clear {
 	class ASTNodeLiteral : public ASTNodeBase
 	{
 	public:
-		ASTNodeLiteral(const std::string& data);
+		ASTNodeLiteral(const NumberLiteral& value);
 		virtual ~ASTNodeLiteral() = default;
-		virtual inline const ASTNodeType GetType() const override { return ASTNodeType::Literal; }
+		static inline bool classof(const ASTNodeBase* node) { return node->GetType() == ASTNodeType::Literal; }
 		virtual llvm::Value* Codegen() override;
 
+	protected:
+		virtual void _SerializeFields(BinaryWriter& writer) const override;
+
 	private:
 		AbstractType m_Type;
-		std::string m_Data;
+		NumberLiteral m_Value;
 	};
 
 	//
@@ -77,19 +100,25 @@ namespace clear {
 	public:
 		ASTBinaryExpression(BinaryExpressionType type, AbstractType expectedType = VariableType::None);
 		virtual ~ASTBinaryExpression() = default;
-		virtual inline const ASTNodeType GetType() const override { return ASTNodeType::BinaryExpression; }
+		static inline bool classof(const ASTNodeBase* node) { return node->GetType() == ASTNodeType::BinaryExpression; }
 		virtual llvm::Value* Codegen() override;
 
 		inline const BinaryExpressionType GetExpression() const { return m_Expression; }
 
+		// the code of an expression whose operands are already generated, shared with the flat ast
+		static llvm::Value* Emit(BinaryExpressionType expression, const AbstractType& expectedType, llvm::Value* LHS, llvm::Value* RHS);
+
+	protected:
+		virtual void _SerializeFields(BinaryWriter& writer) const override;
+
 	private:
-		const bool _IsMathExpression() const;
-		const bool _IsCmpExpression() const;
+		static const bool _IsMathExpression(BinaryExpressionType expression);
+		static const bool _IsCmpExpression(BinaryExpressionType expression);
 
-		llvm::Value* _CreateExpression(llvm::Value* LHS, llvm::Value* RHS, llvm::Value* LHSRawValue, llvm::Value* RHSRawValue);
-		llvm::Value* _CreateMathExpression(llvm::Value* LHS, llvm::Value* RHS);
-		llvm::Value* _CreateCmpExpression(llvm::Value* LHS, llvm::Value* RHS);
-		llvm::Value* _CreateLoadStoreExpression(llvm::Value* LHS, llvm::Value* RHS);
+		static llvm::Value* _CreateExpression(BinaryExpressionType expression, llvm::Value* LHS, llvm::Value* RHS, llvm::Value* LHSRawValue, llvm::Value* RHSRawValue);
+		static llvm::Value* _CreateMathExpression(BinaryExpressionType expression, llvm::Value* LHS, llvm::Value* RHS);
+		static llvm::Value* _CreateCmpExpression(BinaryExpressionType expression, llvm::Value* LHS, llvm::Value* RHS);
+		static llvm::Value* _CreateLoadStoreExpression(BinaryExpressionType expression, llvm::Value* LHS, llvm::Value* RHS);
 
 	private:
 		BinaryExpressionType m_Expression;
@@ -102,7 +131,7 @@ namespace clear {
 
 	struct Paramater
 	{
-		std::string Name;
+		Symbol Name;
 		AbstractType Type; 
 	};
 
@@ -112,15 +141,26 @@ namespace clear {
 	class ASTFunctionDecleration : public ASTNodeBase
 	{
 	public:
-		ASTFunctionDecleration(const std::string& name, VariableType returnType, const std::vector<Paramater>& arugments);
+		ASTFunctionDecleration(Symbol name, VariableType returnType, const std::vector<Paramater>& arugments);
 		virtual ~ASTFunctionDecleration() = default;
-		virtual inline const ASTNodeType GetType() const override { return ASTNodeType::FunctionDecleration; }
+		static inline bool classof(const ASTNodeBase* node) { return node->GetType() == ASTNodeType::FunctionDecleration; }
 		virtual llvm::Value* Codegen() override;
 
-		inline const std::string& GetName() const { return m_Name; }
+		inline Symbol GetName() const { return m_Name; }
+		inline VariableType GetReturnType() const { return m_ReturnType; }
+
+		// calls check their arguments against these, they're known as soon as the function is parsed
+		static void Declare(Symbol name, const std::vector<Paramater>& paramaters);
+
+		// the code around the body, the body's nodes are generated in between
+		static llvm::Function* EmitBegin(Symbol name, VariableType returnType, std::span<const Paramater> paramaters);
+		static void EmitEnd(Symbol name, VariableType returnType, std::span<const Paramater> paramaters);
+
+	protected:
+		virtual void _SerializeFields(BinaryWriter& writer) const override;
 
 	private:
-		std::string m_Name;
+		Symbol m_Name;
 		VariableType m_ReturnType;
 		std::vector<Paramater> m_Paramaters;
 	};
@@ -132,7 +172,8 @@ namespace clear {
 	struct Argument
 	{
 		AbstractType Field;
-		std::string Data;
+		NumberLiteral Value; // the literal passed
+		Symbol Variable;  // the variable passed instead of a literal
 	};
 
 	//
@@ -141,14 +182,18 @@ namespace clear {
 	class ASTFunctionCall : public ASTNodeBase
 	{
 	public:
-		ASTFunctionCall(const std::string& name, const std::vector<Argument>& arugments);
+		ASTFunctionCall(Symbol name, const std::vector<Argument>& arugments);
 		virtual ~ASTFunctionCall() = default;
-		virtual inline const ASTNodeType GetType() const override { return ASTNodeType::FunctionCall; }
+		static inline bool classof(const ASTNodeBase* node) { return node->GetType() == ASTNodeType::FunctionCall; }
 		virtual llvm::Value* Codegen() override;
 
+		static llvm::Value* Emit(Symbol name, std::span<const Argument> arguments);
+
+	protected:
+		virtual void _SerializeFields(BinaryWriter& writer) const override;
 
 	private:
-		std::string m_Name;
+		Symbol m_Name;
 		std::vector<Argument> m_Arguments;
 	};
 	//
@@ -162,15 +207,20 @@ namespace clear {
 	class ASTVariableDecleration : public ASTNodeBase
 	{
 	public:
-		ASTVariableDecleration(const std::string& name, AbstractType type);
+		ASTVariableDecleration(Symbol name, AbstractType type);
 		virtual ~ASTVariableDecleration() = default;
-		virtual inline const ASTNodeType GetType() const override { return ASTNodeType::VariableDecleration; }
+		static inline bool classof(const ASTNodeBase* node) { return node->GetType() == ASTNodeType::VariableDecleration; }
 		virtual llvm::Value* Codegen() override;
 
-		inline const std::string& GetName() const { return m_Name; }
+		inline Symbol GetName() const { return m_Name; }
+
+		static llvm::Value* Emit(Symbol name, const AbstractType& type);
+
+	protected:
+		virtual void _SerializeFields(BinaryWriter& writer) const override;
 
 	private:
-		std::string m_Name;
+		Symbol m_Name;
 		AbstractType m_Type;
 	};
 
@@ -181,15 +231,20 @@ namespace clear {
 	class ASTVariableExpression : public ASTNodeBase
 	{
 	public:
-		ASTVariableExpression(const std::string& name);
+		ASTVariableExpression(Symbol name);
 		virtual ~ASTVariableExpression() = default;
-		virtual inline const ASTNodeType GetType() const override { return ASTNodeType::VariableExpression; }
+		static inline bool classof(const ASTNodeBase* node) { return node->GetType() == ASTNodeType::VariableExpression; }
 		virtual llvm::Value* Codegen() override;
 
-		inline const std::string& GetName() const { return m_Name; }
+		inline Symbol GetName() const { return m_Name; }
+
+		static llvm::Value* Emit(Symbol name);
+
+	protected:
+		virtual void _SerializeFields(BinaryWriter& writer) const override;
 
 	private:
-		std::string m_Name;
+		Symbol m_Name;
 	};
 
 	//
@@ -202,10 +257,20 @@ namespace clear {
 	class ASTReturnStatement : public ASTNodeBase
 	{
 	public:
-		ASTReturnStatement() = default;
+		ASTReturnStatement(AbstractType returnType = VariableType::None)
+			: ASTNodeBase(ASTNodeType::ReturnStatement), m_ReturnType(returnType) {}
 		virtual ~ASTReturnStatement() = default;
-		virtual inline const ASTNodeType GetType() const override { return ASTNodeType::ReturnStatement; }
+		static inline bool classof(const ASTNodeBase* node) { return node->GetType() == ASTNodeType::ReturnStatement; }
 		virtual llvm::Value* Codegen() override;
+
+		// value is cast to the function's return type, a void function or a missing value returns nothing
+		static llvm::Value* Emit(llvm::Value* value, const AbstractType& returnType);
+
+	protected:
+		virtual void _SerializeFields(BinaryWriter& writer) const override;
+
+	private:
+		AbstractType m_ReturnType;
 	};
 
 	//
@@ -219,9 +284,10 @@ namespace clear {
 	class ASTExpression : public ASTNodeBase
 	{
 	public:
-		ASTExpression() = default;
+		ASTExpression()
+			: ASTNodeBase(ASTNodeType::Expression) {}
 		virtual ~ASTExpression() = default;
-		virtual inline const ASTNodeType GetType() const override { return ASTNodeType::Expression; }
+		static inline bool classof(const ASTNodeBase* node) { return node->GetType() == ASTNodeType::Expression; }
 		virtual llvm::Value* Codegen() override;
 
 	};
@@ -245,9 +311,14 @@ namespace clear {
 	public:
 		ASTStruct(const std::string& name, const std::vector<Member>& fields);
 		virtual ~ASTStruct() = default;
-		virtual inline const ASTNodeType GetType() const override { return ASTNodeType::Struct; }
+		static inline bool classof(const ASTNodeBase* node) { return node->GetType() == ASTNodeType::Struct; }
 		virtual llvm::Value* Codegen() override;
 
+		static llvm::Value* Emit(const std::string& name, std::span<const Member> members);
+
+	protected:
+		virtual void _SerializeFields(BinaryWriter& writer) const override;
+
 	private:
 		std::vector<Member> m_Members;
 		std::string m_Name;
@@ -0,0 +1,534 @@
+#include "FlatAST.h"
+
+#include "API/LLVM/LLVMBackend.h"
+#include "Core/Log.h"
+#include "Core/Profiler.h"
+
+#include <iostream>
+
+namespace clear {
+
+	namespace {
+
+		// the same presedence AST::_CreateExpression uses, -1 for tokens that aren't operators
+		int GetPresedence(TokenType type)
+		{
+			switch (type)
+			{
+				case TokenType::DivOp:
+				case TokenType::MulOp:		 return 2;
+				case TokenType::AddOp:
+				case TokenType::SubOp:		 return 1;
+				case TokenType::OpenBracket: return 0;
+				default:					 return -1;
+			}
+		}
+
+	}
+
+	FlatAST::FlatAST(const ProgramInfo& info, const std::string& rootName)
+	{
+		CLEAR_PROFILE_SCOPE("FlatAST::FlatAST");
+
+		// a token makes about one node at most, so the node arrays are only allocated once
+		m_Kinds.reserve(info.Tokens.size());
+		m_Data.reserve(info.Tokens.size());
+		m_Parents.reserve(info.Tokens.size());
+
+		//possibly add command line arguments in the future
+		_PushFunction(Symbol(rootName), VariableType::None, {}, s_InvalidNode);
+
+		_Build(info);
+		_LinkChildren();
+	}
+
+	void FlatAST::BuildIR(const std::filesystem::path& out)
+	{
+		auto& module = *LLVM::Backend::GetModule();
+
+		{
+			CLEAR_PROFILE_SCOPE("FlatAST::Codegen");
+
+			ResetCodegenState();
+			_Codegen(0);
+		}
+
+		if (out.empty())
+			return;
+
+		CLEAR_PROFILE_SCOPE("FlatAST::PrintIR");
+
+		std::error_code EC;
+		llvm::raw_fd_stream stream(out.string(), EC);
+
+		module.print(stream, nullptr);
+	}
+
+	size_t FlatAST::GetMemoryUsage() const
+	{
+		auto bytes = [](const auto& array) { return array.capacity() * sizeof(array[0]); };
+
+		return bytes(m_Kinds) + bytes(m_Data) + bytes(m_Parents) + bytes(m_FirstEdge) + bytes(m_Edges) +
+			   bytes(m_Literals) + bytes(m_Binaries) + bytes(m_VariableExpressions) + bytes(m_VariableDeclerations) +
+			   bytes(m_Functions) + bytes(m_Calls) + bytes(m_Structs) + bytes(m_ReturnTypes) +
+			   bytes(m_Paramaters) + bytes(m_Arguments) + bytes(m_Members);
+	}
+
+	FlatAST::NodeID FlatAST::_Push(ASTNodeType kind, uint32_t data, NodeID parent)
+	{
+		CLEAR_VERIFY(m_Kinds.size() < s_InvalidNode, "too many nodes");
+
+		m_Kinds.push_back(kind);
+		m_Data.push_back(data);
+		m_Parents.push_back(parent);
+
+		return NodeID(m_Kinds.size() - 1);
+	}
+
+	FlatAST::NodeID FlatAST::_PushFunction(Symbol name, VariableType returnType, const std::vector<Paramater>& paramaters, NodeID parent)
+	{
+		// calls are checked against the paramaters before any code is generated, like the tree's constructor does
+		ASTFunctionDecleration::Declare(name, paramaters);
+
+		m_Functions.push_back({ name, returnType, uint32_t(m_Paramaters.size()), uint32_t(paramaters.size()) });
+		m_Paramaters.insert(m_Paramaters.end(), paramaters.begin(), paramaters.end());
+
+		return _Push(ASTNodeType::FunctionDecleration, uint32_t(m_Functions.size() - 1), parent);
+	}
+
+	void FlatAST::_Build(const ProgramInfo& info)
+	{
+		const auto& tokens = info.Tokens;
+
+		// the functions being built, code always goes into the innermost
+		std::vector<NodeID> scopes = { 0 };
+		std::vector<Paramater> Paramaters;
+
+		for (size_t i = 0; i < tokens.size(); i++)
+		{
+			const NodeID currentRoot = scopes.back();
+			const Symbol currentName = m_Functions[m_Data[currentRoot]].Name;
+			const Token currentToken = tokens[i];
+
+			switch (currentToken.TokenType)
+			{
+				case TokenType::Function:
+				{
+					VariableType returnType = VariableType::None;
+					Paramaters.clear();
+
+					i++;
+					const Symbol name(info.GetData(tokens[i]));
+
+					i++;
+					if (tokens[i].TokenType != TokenType::StartFunctionParameters)
+					{
+						break;
+					}
+
+					i++;
+					Paramater currentParamater;
+					while (tokens[i].TokenType != TokenType::EndFunctionParameters)
+					{
+						if (GetVariableTypeFromTokenType(tokens[i].TokenType) != VariableType::None)
+						{
+							currentParamater.Type = GetVariableTypeFromTokenType(tokens[i].TokenType);
+						}
+						else
+						{
+							currentParamater.Name = Symbol(info.GetData(tokens[i]));
+							Paramaters.push_back(currentParamater);
+						}
+
+						i++;
+					}
+
+					// an arrow after the paramaters is followed by the return type
+					if (i + 3 < tokens.size() && tokens[i + 1].TokenType == TokenType::Arrow)
+					{
+						i += 3;
+
+						returnType = GetVariableTypeFromTokenType(tokens[i].TokenType);
+						CLEAR_VERIFY(returnType != VariableType::None, "unsupported return type");
+					}
+
+					scopes.push_back(_PushFunction(name, returnType, Paramaters, currentRoot));
+					break;
+				}
+				case TokenType::FunctionCall:
+				{
+					const Symbol name(info.GetData(tokens[i]));
+					const uint32_t firstArgument = uint32_t(m_Arguments.size());
+
+					i++;
+
+					CLEAR_VERIFY(tokens[i].TokenType == TokenType::OpenBracket,"");
+					i++;
+
+					while (tokens[i].TokenType != TokenType::CloseBracket)
+					{
+						if (tokens[i].TokenType == TokenType::Comma)
+						{
+							i++;
+							continue;
+						}
+
+						Argument arg;
+
+						switch (tokens[i].TokenType)
+						{
+							case TokenType::RValueNumber:
+							case TokenType::BooleanData:
+							{
+								if (tokens[i].TokenType == TokenType::RValueNumber)
+									arg.Value = info.GetLiteral(tokens[i]);
+								else
+									arg.Value = DecodeBoolLiteral(info.GetData(tokens[i]));
+
+								arg.Field = AbstractType(arg.Value);
+
+								m_Arguments.push_back(arg);
+
+								break;
+							}
+							case TokenType::VariableReference:
+							{
+								arg.Field = AbstractType(tokens[i], TypeKind::Variable);
+								arg.Variable = Symbol(currentName, Symbol(info.GetData(tokens[i])));
+
+								m_Arguments.push_back(arg);
+
+								break;
+							}
+							default:
+							{
+								CLEAR_ANNOTATED_HALT("tokens of all types haven't been dealt with yet"); //TODO
+								break;
+							}
+						}
+
+						i++;
+					}
+
+					m_Calls.push_back({ name, firstArgument, uint32_t(m_Arguments.size()) - firstArgument });
+					_Push(ASTNodeType::FunctionCall, uint32_t(m_Calls.size() - 1), currentRoot);
+					break;
+				}
+				case TokenType::VariableName:
+				{
+					const Token previous = tokens[i - 1];
+
+					AbstractType type;
+
+					if (previous.TokenType == TokenType::VariableReference)
+						type = AbstractType(VariableType::UserDefinedType, TypeKind::Variable, std::string(info.GetData(previous)));
+					else
+						type = AbstractType(previous, TypeKind::Variable);
+
+					m_VariableDeclerations.push_back({ Symbol(currentName, Symbol(info.GetData(currentToken))), type });
+					_Push(ASTNodeType::VariableDecleration, uint32_t(m_VariableDeclerations.size() - 1), currentRoot);
+					break;
+				}
+				case TokenType::Struct:
+				{
+					i++;
+
+					CLEAR_VERIFY(tokens[i].TokenType == TokenType::StructName, "invalid token after struct");
+
+					StructNode node;
+					node.Name = std::string(info.GetData(tokens[i]));
+					node.FirstMember = uint32_t(m_Members.size());
+
+					while (tokens[i].TokenType != TokenType::StartIndentation)
+						i++;
+
+					i++;
+
+					while (i < tokens.size() && (tokens[i].TokenType == TokenType::VariableReference ||
+						   GetVariableTypeFromTokenType(tokens[i].TokenType) != VariableType::None))
+					{
+						Member member;
+
+						if (tokens[i].TokenType == TokenType::VariableReference)
+						{
+							member.Field = AbstractType(VariableType::UserDefinedType, TypeKind::Variable, std::string(info.GetData(tokens[i])));
+						}
+						else
+						{
+							member.Field = GetVariableTypeFromTokenType(tokens[i].TokenType);
+						}
+
+						i++;
+						member.Name = info.GetData(tokens[i]);
+						m_Members.push_back(member);
+
+						i++;
+					}
+
+					node.MemberCount = uint32_t(m_Members.size()) - node.FirstMember;
+
+					m_Structs.push_back(std::move(node));
+					_Push(ASTNodeType::Struct, uint32_t(m_Structs.size() - 1), currentRoot);
+					break;
+				}
+				case TokenType::Assignment:
+				{
+					const Token previous = tokens[i - 1];
+					const Token assignmentType = tokens[i - 2];
+					AbstractType type(assignmentType);
+
+					m_Binaries.push_back({ BinaryExpressionType::Assignment, type });
+					const NodeID binaryExpression = _Push(ASTNodeType::BinaryExpression, uint32_t(m_Binaries.size() - 1), currentRoot);
+
+					_BuildExpression(info, binaryExpression, currentName, i, type);
+
+					m_VariableExpressions.push_back(Symbol(currentName, Symbol(info.GetData(previous))));
+					_Push(ASTNodeType::VariableExpression, uint32_t(m_VariableExpressions.size() - 1), binaryExpression);
+
+					break;
+				}
+				case TokenType::Return:
+				{
+					const AbstractType returnType(m_Functions[m_Data[currentRoot]].ReturnType);
+
+					m_ReturnTypes.push_back(returnType);
+					const NodeID returnStatement = _Push(ASTNodeType::ReturnStatement, uint32_t(m_ReturnTypes.size() - 1), currentRoot);
+
+					if (i + 1 < tokens.size() && tokens[i + 1].TokenType != TokenType::EndLine)
+						_BuildExpression(info, returnStatement, currentName, i, returnType);
+
+					break;
+				}
+				case TokenType::EndIndentation:
+				{
+					if (scopes.size() > 1)
+					{
+						scopes.pop_back();
+					}
+
+					break;
+				}
+				default:
+					break;
+			}
+		}
+	}
+
+	void FlatAST::_BuildExpression(const ProgramInfo& info, NodeID parent, Symbol root, size_t& start, const AbstractType& expectedType)
+	{
+		const auto& tokens = info.Tokens;
+
+		// the children are the operands and operators in reverse polish order
+		const NodeID expression = _Push(ASTNodeType::Expression, 0, parent);
+		start += 1;
+
+		m_Operators.clear();
+
+		auto pushOperator = [&]()
+			{
+				m_Binaries.push_back({ GetBinaryExpressionTypeFromTokenType(m_Operators.back().TokenType), expectedType });
+				_Push(ASTNodeType::BinaryExpression, uint32_t(m_Binaries.size() - 1), expression);
+				m_Operators.pop_back();
+			};
+
+		while (start < tokens.size() && tokens[start].TokenType != TokenType::EndLine && tokens[start].TokenType != TokenType::EndIndentation)
+		{
+			const Token token = tokens[start];
+
+			if (token.TokenType == TokenType::VariableReference)
+			{
+				m_VariableExpressions.push_back(Symbol(root, Symbol(info.GetData(token))));
+				_Push(ASTNodeType::VariableExpression, uint32_t(m_VariableExpressions.size() - 1), expression);
+			}
+			else if (token.TokenType == TokenType::RValueNumber)
+			{
+				m_Literals.push_back(info.GetLiteral(token));
+				_Push(ASTNodeType::Literal, uint32_t(m_Literals.size() - 1), expression);
+			}
+			else if (token.TokenType == TokenType::OpenBracket)
+			{
+				m_Operators.push_back(token);
+			}
+			else if (token.TokenType == TokenType::CloseBracket)
+			{
+				while (!m_Operators.empty() && m_Operators.back().TokenType != TokenType::OpenBracket)
+					pushOperator();
+
+				if (!m_Operators.empty())
+					m_Operators.pop_back();
+			}
+			else if (GetPresedence(token.TokenType) >= 0)
+			{
+				while (!m_Operators.empty() && m_Operators.back().TokenType != TokenType::OpenBracket &&
+					GetPresedence(token.TokenType) <= GetPresedence(m_Operators.back().TokenType))
+				{
+					pushOperator();
+				}
+
+				m_Operators.push_back(token);
+			}
+
+			start++;
+		}
+
+		start--;
+
+		while (!m_Operators.empty())
+			pushOperator();
+	}
+
+	void FlatAST::_LinkChildren()
+	{
+		const size_t count = m_Kinds.size();
+
+		// counts the children of every node, then places them. nodes are visited in the order they were made,
+		// which keeps each node's children in order
+		m_FirstEdge.assign(count + 1, 0);
+
+		for (size_t node = 0; node < count; node++)
+		{
+			if (m_Parents[node] != s_InvalidNode)
+				m_FirstEdge[m_Parents[node] + 1]++;
+		}
+
+		for (size_t node = 0; node < count; node++)
+			m_FirstEdge[node + 1] += m_FirstEdge[node];
+
+		m_Edges.resize(m_FirstEdge[count]);
+
+		std::vector<uint32_t> next(m_FirstEdge.begin(), m_FirstEdge.end() - 1);
+
+		for (size_t node = 0; node < count; node++)
+		{
+			if (m_Parents[node] != s_InvalidNode)
+				m_Edges[next[m_Parents[node]]++] = NodeID(node);
+		}
+	}
+
+	llvm::Value* FlatAST::_Codegen(NodeID node)
+	{
+		const uint32_t data = m_Data[node];
+		const std::span<const NodeID> children = GetChildren(node);
+
+		switch (m_Kinds[node])
+		{
+			case ASTNodeType::FunctionDecleration:
+			{
+				const FunctionNode& function = m_Functions[data];
+				const std::span<const Paramater> paramaters(m_Paramaters.data() + function.FirstParamater, function.ParamaterCount);
+
+				CLEAR_PROFILE_DETAIL_SCOPE(function.Name.GetString());
+
+				llvm::Function* value = ASTFunctionDecleration::EmitBegin(function.Name, function.ReturnType, paramaters);
+
+				for (NodeID child : children)
+				{
+					_Codegen(child);
+
+					if (m_Kinds[child] == ASTNodeType::ReturnStatement)
+						break;
+				}
+
+				ASTFunctionDecleration::EmitEnd(function.Name, function.ReturnType, paramaters);
+
+				return value;
+			}
+			case ASTNodeType::Literal:
+			{
+				const NumberLiteral& literal = m_Literals[data];
+				return GetLLVMConstant(AbstractType(literal).Get(), literal);
+			}
+			case ASTNodeType::BinaryExpression:
+			{
+				if (children.size() != 2)
+					return nullptr;
+
+				llvm::Value* LHS = _Codegen(children[1]);
+				llvm::Value* RHS = _Codegen(children[0]);
+
+				return ASTBinaryExpression::Emit(m_Binaries[data].Expression, m_Binaries[data].ExpectedType, LHS, RHS);
+			}
+			case ASTNodeType::VariableExpression:
+				return ASTVariableExpression::Emit(m_VariableExpressions[data]);
+			case ASTNodeType::VariableDecleration:
+				return ASTVariableDecleration::Emit(m_VariableDeclerations[data].Name, m_VariableDeclerations[data].Type);
+			case ASTNodeType::ReturnStatement:
+			{
+				const AbstractType& returnType = m_ReturnTypes[data];
+
+				if (children.size() > 0 && returnType.Get() != VariableType::None)
+					return ASTReturnStatement::Emit(_Codegen(children[0]), returnType);
+
+				return ASTReturnStatement::Emit(nullptr, returnType);
+			}
+			case ASTNodeType::Expression:
+				return _CodegenExpression(node);
+			case ASTNodeType::Struct:
+			{
+				const StructNode& structNode = m_Structs[data];
+				return ASTStruct::Emit(structNode.Name, std::span<const Member>(m_Members.data() + structNode.FirstMember, structNode.MemberCount));
+			}
+			case ASTNodeType::FunctionCall:
+			{
+				const CallNode& call = m_Calls[data];
+				return ASTFunctionCall::Emit(call.Name, std::span<const Argument>(m_Arguments.data() + call.FirstArgument, call.ArgumentCount));
+			}
+			default:
+			{
+				for (NodeID child : children)
+					_Codegen(child);
+
+				return nullptr;
+			}
+		}
+	}
+
+	llvm::Value* FlatAST::_CodegenExpression(NodeID node)
+	{
+		// the code comes out in the same order as the operator tree the tree ast builds from the same tokens
+		const std::span<const NodeID> children = GetChildren(node);
+		const size_t base = m_Values.size();
+
+		// an expression the parser got wrong can leave several values, only the last one is used. it is built from
+		// the children after first, which is found walking back until every operator has its operands
+		size_t first = children.size();
+
+		for (size_t needed = 1; needed > 0 && first > 0; )
+		{
+			first--;
+
+			if (m_Kinds[children[first]] == ASTNodeType::BinaryExpression)
+				needed++;
+			else
+				needed--;
+		}
+
+		for (NodeID child : children.subspan(first))
+		{
+			if (m_Kinds[child] != ASTNodeType::BinaryExpression)
+			{
+				m_Values.push_back(_Codegen(child));
+				continue;
+			}
+
+			CLEAR_VERIFY(m_Values.size() >= base + 2, "operator is missing an operand");
+
+			llvm::Value* RHS = m_Values.back();
+			m_Values.pop_back();
+
+			llvm::Value* LHS = m_Values.back();
+			m_Values.pop_back();
+
+			const BinaryNode& binary = m_Binaries[m_Data[child]];
+			m_Values.push_back(ASTBinaryExpression::Emit(binary.Expression, binary.ExpectedType, LHS, RHS));
+		}
+
+		CLEAR_VERIFY(m_Values.size() > base, "expression has no operands");
+
+		llvm::Value* value = m_Values.back();
+		m_Values.resize(base);
+
+		return value;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "ASTNode.h"
+#include "Parsing/Parser.h"
+#include "API/LLVM/LLVMInclude.h"
+
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace clear {
+
+    // the same program as an AST, with its nodes kept in flat arrays instead of each being its own object.
+    // a node is a 32 bit index, its kind and the index of its fields in that kind's array sit side by side and
+    // the children of every node are one range of a shared edge array. building is a handful of vector appends
+    // per node, and codegen walks the arrays with a switch instead of virtual calls
+    class FlatAST
+    {
+    public:
+        using NodeID = uint32_t;
+        static constexpr NodeID s_InvalidNode = UINT32_MAX;
+
+        // top level code is generated into a function called rootName, the root is always node 0
+        FlatAST(const ProgramInfo& info, const std::string& rootName = "main");
+        ~FlatAST() = default;
+
+        // generates the module, the textual ir is also written to out when a path is given
+        void BuildIR(const std::filesystem::path& out = {});
+
+        inline size_t GetNodeCount() const { return m_Kinds.size(); }
+        inline ASTNodeType GetKind(NodeID node) const { return m_Kinds[node]; }
+        inline NodeID GetParent(NodeID node) const { return m_Parents[node]; }
+
+        // in the order they were built, the same order as the children of the tree
+        inline std::span<const NodeID> GetChildren(NodeID node) const
+        {
+            return std::span<const NodeID>(m_Edges.data() + m_FirstEdge[node], m_FirstEdge[node + 1] - m_FirstEdge[node]);
+        }
+
+        // bytes held by the node, edge and field arrays
+        size_t GetMemoryUsage() const;
+
+    private:
+        NodeID _Push(ASTNodeType kind, uint32_t data, NodeID parent);
+        NodeID _PushFunction(Symbol name, VariableType returnType, const std::vector<Paramater>& paramaters, NodeID parent);
+
+        void _Build(const ProgramInfo& info);
+        void _BuildExpression(const ProgramInfo& info, NodeID parent, Symbol root, size_t& start, const AbstractType& expectedType);
+        void _LinkChildren();
+
+        llvm::Value* _Codegen(NodeID node);
+        llvm::Value* _CodegenExpression(NodeID node);
+
+    private:
+        struct BinaryNode
+        {
+            BinaryExpressionType Expression;
+            AbstractType ExpectedType;
+        };
+
+        struct VariableNode
+        {
+            Symbol Name;
+            AbstractType Type;
+        };
+
+        struct FunctionNode
+        {
+            Symbol Name;
+            VariableType ReturnType;
+            uint32_t FirstParamater = 0;
+            uint32_t ParamaterCount = 0;
+        };
+
+        struct CallNode
+        {
+            Symbol Name;
+            uint32_t FirstArgument = 0;
+            uint32_t ArgumentCount = 0;
+        };
+
+        struct StructNode
+        {
+            std::string Name;
+            uint32_t FirstMember = 0;
+            uint32_t MemberCount = 0;
+        };
+
+    private:
+        // one entry per node
+        std::vector<ASTNodeType> m_Kinds;
+        std::vector<uint32_t> m_Data; // index into the array of the node's kind
+        std::vector<NodeID> m_Parents;
+
+        // the children of node n are m_Edges[m_FirstEdge[n]] up to m_Edges[m_FirstEdge[n + 1]]
+        std::vector<uint32_t> m_FirstEdge;
+        std::vector<NodeID> m_Edges;
+
+        // the fields of each kind, expressions have none
+        std::vector<NumberLiteral> m_Literals;
+        std::vector<BinaryNode> m_Binaries;
+        std::vector<Symbol> m_VariableExpressions;
+        std::vector<VariableNode> m_VariableDeclerations;
+        std::vector<FunctionNode> m_Functions;
+        std::vector<CallNode> m_Calls;
+        std::vector<StructNode> m_Structs;
+        std::vector<AbstractType> m_ReturnTypes;
+
+        std::vector<Paramater> m_Paramaters;
+        std::vector<Argument> m_Arguments;
+        std::vector<Member> m_Members;
+
+        // reused by every expression while building and generating
+        std::vector<Token> m_Operators;
+        std::vector<llvm::Value*> m_Values;
+    };
+
+}
\ No newline at end of file
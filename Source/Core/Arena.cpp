@@ -0,0 +1,30 @@
+#include "Arena.h"
+
+#include <algorithm>
+
+namespace clear {
+
+    Arena::~Arena()
+    {
+        for (auto it = m_Destructors.rbegin(); it != m_Destructors.rend(); it++)
+            it->Destroy(it->Object);
+
+        // the retained arenas are released after this, their objects may have been referenced until now
+    }
+
+    void* Arena::Allocate(size_t size, size_t alignment)
+    {
+        m_BytesUsed += size;
+        return m_Allocator.Allocate(size, llvm::Align(alignment));
+    }
+
+    void Arena::Retain(const std::shared_ptr<Arena>& other)
+    {
+        if (!other || other.get() == this)
+            return;
+
+        if (std::find(m_Retained.begin(), m_Retained.end(), other) == m_Retained.end())
+            m_Retained.push_back(other);
+    }
+
+}
\ No newline at end of file
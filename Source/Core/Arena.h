@@ -0,0 +1,56 @@
+#pragma once
+
+#include <llvm/Support/Allocator.h>
+
+#include <vector>
+#include <memory>
+#include <utility>
+#include <type_traits>
+
+namespace clear {
+
+    // a bump allocator for objects that all die together. objects are constructed in place and destroyed when the
+    // arena is, in the reverse order they were created, and the memory goes back in a few large slabs
+    class Arena
+    {
+    public:
+        Arena() = default;
+        ~Arena();
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        template<typename Type, typename ...Args>
+        Type* Create(Args&&... args)
+        {
+            Type* object = new (Allocate(sizeof(Type), alignof(Type))) Type(std::forward<Args>(args)...);
+
+            if constexpr (!std::is_trivially_destructible_v<Type>)
+                m_Destructors.push_back({ object, [](void* object) { static_cast<Type*>(object)->~Type(); } });
+
+            return object;
+        }
+
+        void* Allocate(size_t size, size_t alignment);
+
+        // objects in this arena point at objects in other, so other is kept until this arena's objects are destroyed
+        void Retain(const std::shared_ptr<Arena>& other);
+
+        inline size_t GetBytesUsed()     const { return m_BytesUsed; }
+        inline size_t GetBytesReserved() const { return m_Allocator.getTotalMemory(); }
+
+    private:
+        struct Destructor
+        {
+            void* Object = nullptr;
+            void (*Destroy)(void*) = nullptr;
+        };
+
+        llvm::BumpPtrAllocator m_Allocator;
+        std::vector<Destructor> m_Destructors;
+        std::vector<std::shared_ptr<Arena>> m_Retained;
+
+        size_t m_BytesUsed = 0;
+    };
+
+}
\ No newline at end of file
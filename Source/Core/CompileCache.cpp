@@ -0,0 +1,245 @@
+#include "CompileCache.h"
+
+#include "Log.h"
+#include "Profiler.h"
+
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <iomanip>
+
+#ifndef CLEAR_VERSION
+    #define CLEAR_VERSION "unknown"
+#endif
+
+namespace clear {
+
+    namespace {
+
+        // bumped whenever anything written into an entry changes its layout
+        constexpr uint32_t s_FormatVersion = 5;
+        constexpr uint32_t s_Magic = 0x43524c43; // "CLRC"
+
+        struct EntryHeader
+        {
+            uint32_t Magic = s_Magic;
+            uint32_t Format = s_FormatVersion;
+            uint64_t Key = 0;
+            uint64_t Size = 0;
+            uint64_t Checksum = 0;
+        };
+
+        uint64_t Hash(std::string_view data)
+        {
+            return llvm::xxh3_64bits(llvm::ArrayRef<uint8_t>((const uint8_t*)data.data(), data.size()));
+        }
+
+    }
+
+    CompileCache::CompileCache(const std::filesystem::path& directory, uint64_t maxSize)
+        : m_Directory(directory), m_MaxSize(maxSize)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(m_Directory, error);
+
+        if (error)
+            CLEAR_LOG_WARNING("failed to create cache directory ", m_Directory, ": ", error.message());
+    }
+
+    uint64_t CompileCache::GetKey(std::string_view source, std::string_view context)
+    {
+        CLEAR_PROFILE_SCOPE("CompileCache::GetKey");
+
+        const std::string salt = std::string(GetCompilerVersion()) + '\0' + std::string(context);
+        return Hash(source) ^ (Hash(salt) * 0x9e3779b97f4a7c15ull);
+    }
+
+    std::string_view CompileCache::GetCompilerVersion()
+    {
+        static const std::string s_Version = "clear " CLEAR_VERSION ", llvm " LLVM_VERSION_STRING ", format " + std::to_string(s_FormatVersion);
+        return s_Version;
+    }
+
+    std::unique_ptr<llvm::MemoryBuffer> CompileCache::Load(uint64_t key)
+    {
+        CLEAR_PROFILE_SCOPE("CompileCache::Load");
+
+        const std::filesystem::path path = _GetPath(key);
+
+        // large entries are memory mapped, only the pages that are read get loaded
+        auto buffer = llvm::MemoryBuffer::getFile(path.string(), /*IsText=*/false, /*RequiresNullTerminator=*/false);
+
+        if (!buffer)
+        {
+            m_Stats.Misses++;
+            return nullptr;
+        }
+
+        std::unique_ptr<llvm::MemoryBuffer> entry = std::move(*buffer);
+
+        EntryHeader header;
+        bool valid = entry->getBufferSize() >= sizeof(EntryHeader);
+
+        if (valid)
+        {
+            std::memcpy(&header, entry->getBufferStart(), sizeof(EntryHeader));
+
+            valid = header.Magic == s_Magic && header.Format == s_FormatVersion && header.Key == key &&
+                    header.Size == entry->getBufferSize() - sizeof(EntryHeader) &&
+                    header.Checksum == Hash(GetData(*entry));
+        }
+
+        std::error_code error;
+
+        // a truncated write or a different build that hashed to the same name, it would be replaced anyway
+        if (!valid)
+        {
+            entry.reset();
+            std::filesystem::remove(path, error);
+
+            m_Stats.Misses++;
+            return nullptr;
+        }
+
+        // the modification time is the last use, eviction removes the oldest entries first
+        std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+
+        m_Stats.Hits++;
+        m_Stats.BytesLoaded += header.Size;
+
+        return entry;
+    }
+
+    void CompileCache::Store(uint64_t key, std::string_view data)
+    {
+        CLEAR_PROFILE_SCOPE("CompileCache::Store");
+
+        EntryHeader header;
+        header.Key = key;
+        header.Size = data.size();
+        header.Checksum = Hash(data);
+
+        // written to a temporary file and renamed, another compiler never maps a half written entry
+        auto temp = llvm::sys::fs::TempFile::create((m_Directory / "%%%%%%%%%%%%.tmp").string());
+
+        if (!temp)
+        {
+            CLEAR_LOG_WARNING("failed to write cache entry: ", llvm::toString(temp.takeError()));
+            return;
+        }
+
+        bool written = true;
+
+        {
+            llvm::raw_fd_ostream stream(temp->FD, /*shouldClose=*/false);
+            stream.write((const char*)&header, sizeof(EntryHeader));
+            stream.write(data.data(), data.size());
+            stream.flush();
+
+            // a stream destroyed with an error is a fatal error, the cache is optional so it is only a warning
+            if (stream.has_error())
+            {
+                CLEAR_LOG_WARNING("failed to write cache entry: ", stream.error().message());
+                stream.clear_error();
+                written = false;
+            }
+        }
+
+        if (!written)
+        {
+            llvm::consumeError(temp->discard());
+            return;
+        }
+
+        if (llvm::Error error = temp->keep(_GetPath(key).string()))
+        {
+            CLEAR_LOG_WARNING("failed to write cache entry: ", llvm::toString(std::move(error)));
+            return;
+        }
+
+        m_Stats.Stores++;
+        m_Stats.BytesStored += data.size();
+
+        _Evict();
+    }
+
+    std::string_view CompileCache::GetData(const llvm::MemoryBuffer& entry)
+    {
+        return std::string_view(entry.getBufferStart() + sizeof(EntryHeader), entry.getBufferSize() - sizeof(EntryHeader));
+    }
+
+    void CompileCache::PrintStats() const
+    {
+        const size_t lookups = m_Stats.Hits + m_Stats.Misses;
+        const double hitRate = lookups ? 100.0 * double(m_Stats.Hits) / double(lookups) : 0.0;
+
+        std::cout << "------CACHE REPORT--------" << std::endl;
+        std::cout << "hits: " << m_Stats.Hits << ", misses: " << m_Stats.Misses
+                  << ", hit rate: " << std::fixed << std::setprecision(1) << hitRate << "%" << std::endl;
+        std::cout << "loaded: " << m_Stats.BytesLoaded << " bytes, stored: " << m_Stats.Stores << " entries ("
+                  << m_Stats.BytesStored << " bytes), evicted: " << m_Stats.Evictions << " entries" << std::endl;
+    }
+
+    std::filesystem::path CompileCache::_GetPath(uint64_t key) const
+    {
+        std::string name(16, '0');
+
+        for (size_t i = 0; i < 16; i++)
+            name[15 - i] = "0123456789abcdef"[(key >> (i * 4)) & 0xf];
+
+        return m_Directory / (name + ".clc");
+    }
+
+    void CompileCache::_Evict()
+    {
+        CLEAR_PROFILE_SCOPE("CompileCache::Evict");
+
+        struct Entry
+        {
+            std::filesystem::path Path;
+            uint64_t Size = 0;
+            std::filesystem::file_time_type LastUse;
+        };
+
+        std::vector<Entry> entries;
+        uint64_t totalSize = 0;
+
+        std::error_code error;
+
+        for (const auto& file : std::filesystem::directory_iterator(m_Directory, error))
+        {
+            if (!file.is_regular_file(error) || file.path().extension() != ".clc")
+                continue;
+
+            Entry& entry = entries.emplace_back();
+            entry.Path = file.path();
+            entry.Size = file.file_size(error);
+            entry.LastUse = file.last_write_time(error);
+
+            totalSize += entry.Size;
+        }
+
+        if (totalSize <= m_MaxSize)
+            return;
+
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.LastUse < b.LastUse; });
+
+        for (const Entry& entry : entries)
+        {
+            if (totalSize <= m_MaxSize)
+                break;
+
+            if (!std::filesystem::remove(entry.Path, error))
+                continue;
+
+            totalSize -= entry.Size;
+            m_Stats.Evictions++;
+        }
+    }
+
+}
\ No newline at end of file
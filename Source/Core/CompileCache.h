@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <memory>
+#include <cstdint>
+
+#include <llvm/Support/MemoryBuffer.h>
+
+namespace clear {
+
+    struct CacheStats
+    {
+        size_t Hits = 0;
+        size_t Misses = 0;
+        size_t Stores = 0;
+        size_t Evictions = 0;
+        uint64_t BytesLoaded = 0;
+        uint64_t BytesStored = 0;
+    };
+
+    // a directory of build results addressed by the content they were built from. entries are memory mapped
+    // when loaded and the least recently used ones are removed once the directory grows past maxSize bytes
+    class CompileCache
+    {
+    public:
+        CompileCache(const std::filesystem::path& directory, uint64_t maxSize);
+
+        // hashes the source together with the compiler version and anything else the result depends on
+        static uint64_t GetKey(std::string_view source, std::string_view context);
+        static std::string_view GetCompilerVersion();
+
+        // the entry's data or null on a miss, entries that fail their checksum are removed and count as misses
+        std::unique_ptr<llvm::MemoryBuffer> Load(uint64_t key);
+        void Store(uint64_t key, std::string_view data);
+
+        static std::string_view GetData(const llvm::MemoryBuffer& entry);
+
+        const CacheStats& GetStats() const { return m_Stats; }
+        void PrintStats() const;
+
+    private:
+        std::filesystem::path _GetPath(uint64_t key) const;
+        void _Evict();
+
+    private:
+        std::filesystem::path m_Directory;
+        uint64_t m_MaxSize = 0;
+
+        CacheStats m_Stats;
+    };
+
+}
\ No newline at end of file
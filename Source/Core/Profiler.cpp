@@ -0,0 +1,206 @@
+#include "Profiler.h"
+
+#include "Log.h"
+
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <map>
+
+namespace clear {
+
+    struct OpenEvent
+    {
+        std::string Name;
+        std::string Category;
+        double Start = 0.0;
+    };
+
+    static thread_local std::vector<OpenEvent> s_OpenEvents;
+
+    static std::string EscapeJson(std::string_view str)
+    {
+        std::string escaped;
+        escaped.reserve(str.size());
+
+        for (char c : str)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+
+            escaped += c;
+        }
+
+        return escaped;
+    }
+
+    void Profiler::BeginSession(bool detailed)
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+
+        s_Results.clear();
+        s_SessionStart = std::chrono::steady_clock::now();
+        s_SessionDuration = 0.0;
+
+        s_Enabled  = true;
+        s_Detailed = detailed;
+    }
+
+    void Profiler::EndSession()
+    {
+        s_SessionDuration = GetTime();
+
+        s_Enabled  = false;
+        s_Detailed = false;
+    }
+
+    void Profiler::BeginEvent(std::string_view name, std::string_view category)
+    {
+        if (!s_Enabled)
+            return;
+
+        s_OpenEvents.push_back({ .Name = std::string(name), .Category = std::string(category), .Start = GetTime() });
+    }
+
+    void Profiler::EndEvent()
+    {
+        if (s_OpenEvents.empty())
+            return;
+
+        OpenEvent& event = s_OpenEvents.back();
+
+        Record({ .Name = std::move(event.Name), .Category = std::move(event.Category),
+                 .Start = event.Start, .Duration = GetTime() - event.Start, .ThreadID = GetThreadID() });
+
+        s_OpenEvents.pop_back();
+    }
+
+    void Profiler::Record(ProfileResult&& result)
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        s_Results.push_back(std::move(result));
+    }
+
+    double Profiler::GetTime()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - s_SessionStart;
+        return std::chrono::duration<double, std::micro>(elapsed).count();
+    }
+
+    uint32_t Profiler::GetThreadID()
+    {
+        static std::atomic<uint32_t> s_NextThreadID = 0;
+        static thread_local uint32_t s_ThreadID = s_NextThreadID++;
+
+        return s_ThreadID;
+    }
+
+    void Profiler::WriteChromeTrace(const std::filesystem::path& path)
+    {
+        std::ofstream stream(path);
+
+        if (!stream.is_open())
+        {
+            CLEAR_LOG_ERROR("failed to open trace file ", path.string());
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(s_Mutex);
+
+        stream << std::fixed << std::setprecision(3);
+        stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        for (size_t i = 0; i < s_Results.size(); i++)
+        {
+            const ProfileResult& result = s_Results[i];
+
+            if (i > 0)
+                stream << ",";
+
+            stream << "\n{\"name\":\"" << EscapeJson(result.Name) << "\",\"cat\":\"" << EscapeJson(result.Category) << "\"";
+            stream << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << result.ThreadID;
+            stream << ",\"ts\":" << result.Start << ",\"dur\":" << result.Duration << "}";
+        }
+
+        stream << "\n]}\n";
+    }
+
+    void Profiler::PrintSummary()
+    {
+        struct Summary
+        {
+            size_t Calls = 0;
+            double Total = 0.0;
+        };
+
+        std::map<std::pair<std::string, std::string>, Summary> summaries;
+
+        {
+            std::lock_guard<std::mutex> lock(s_Mutex);
+
+            for (const ProfileResult& result : s_Results)
+            {
+                Summary& summary = summaries[{ result.Category, result.Name }];
+                summary.Calls++;
+                summary.Total += result.Duration;
+            }
+        }
+
+        std::vector<std::pair<std::pair<std::string, std::string>, Summary>> sorted(summaries.begin(), summaries.end());
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second.Total > b.second.Total; });
+
+        const double wall = s_SessionDuration > 0.0 ? s_SessionDuration : GetTime();
+
+        std::cout << "------TIME REPORT--------" << std::endl;
+        std::cout << std::left << std::setw(10) << "Category" << std::setw(48) << "Name"
+                  << std::right << std::setw(8) << "Calls" << std::setw(14) << "Total (ms)" << std::setw(14) << "Avg (ms)" << std::setw(10) << "Wall %" << std::endl;
+
+        std::cout << std::fixed << std::setprecision(3);
+
+        for (const auto& [key, summary] : sorted)
+        {
+            std::string name = key.second.size() > 46 ? key.second.substr(0, 43) + "..." : key.second;
+
+            std::cout << std::left << std::setw(10) << key.first << std::setw(48) << name
+                      << std::right << std::setw(8) << summary.Calls
+                      << std::setw(14) << summary.Total / 1000.0
+                      << std::setw(14) << summary.Total / 1000.0 / summary.Calls
+                      << std::setw(9) << std::setprecision(1) << (wall > 0.0 ? summary.Total / wall * 100.0 : 0.0) << "%"
+                      << std::setprecision(3) << std::endl;
+        }
+
+        std::cout << "Total wall time: " << wall / 1000.0 << " ms" << std::endl;
+        std::cout << std::defaultfloat;
+    }
+
+    ProfileTimer::ProfileTimer(std::string_view name, std::string_view category, bool enabled)
+        : m_Running(enabled)
+    {
+        if (!m_Running)
+            return;
+
+        m_Result.Name = name;
+        m_Result.Category = category;
+        m_Result.Start = Profiler::GetTime();
+    }
+
+    ProfileTimer::~ProfileTimer()
+    {
+        Stop();
+    }
+
+    void ProfileTimer::Stop()
+    {
+        if (!m_Running)
+            return;
+
+        m_Result.Duration = Profiler::GetTime() - m_Result.Start;
+        m_Result.ThreadID = Profiler::GetThreadID();
+
+        Profiler::Record(std::move(m_Result));
+        m_Running = false;
+    }
+
+}
\ No newline at end of file
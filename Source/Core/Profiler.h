@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <filesystem>
+
+namespace clear {
+
+    struct ProfileResult
+    {
+        std::string Name;
+        std::string Category;
+        double Start = 0.0;    // microseconds since the session began
+        double Duration = 0.0; // microseconds
+        uint32_t ThreadID = 0;
+    };
+
+    // collects timings for every phase of a compilation, timers are free when no session is running
+    class Profiler
+    {
+    public:
+        static void BeginSession(bool detailed = false);
+        static void EndSession();
+
+        static bool IsEnabled()  { return s_Enabled; }
+        static bool IsDetailed() { return s_Detailed; }
+
+        // for events that can't be scoped (e.g llvm pass callbacks), events nest per thread
+        static void BeginEvent(std::string_view name, std::string_view category);
+        static void EndEvent();
+
+        static void Record(ProfileResult&& result);
+
+        static double GetTime();
+        static uint32_t GetThreadID();
+
+        // writes the chrome trace event format, can be loaded into chrome://tracing or perfetto
+        static void WriteChromeTrace(const std::filesystem::path& path);
+        static void PrintSummary();
+
+    private:
+        inline static bool s_Enabled  = false;
+        inline static bool s_Detailed = false;
+
+        inline static std::chrono::steady_clock::time_point s_SessionStart;
+        inline static double s_SessionDuration = 0.0;
+
+        inline static std::mutex s_Mutex;
+        inline static std::vector<ProfileResult> s_Results;
+    };
+
+    class ProfileTimer
+    {
+    public:
+        ProfileTimer(std::string_view name, std::string_view category = "clear", bool enabled = Profiler::IsEnabled());
+        ~ProfileTimer();
+
+        void Stop();
+
+    private:
+        bool m_Running = false;
+        ProfileResult m_Result;
+    };
+
+}
+
+#define CLEAR_PROFILE_CONCAT_INNER(a, b) a##b
+#define CLEAR_PROFILE_CONCAT(a, b) CLEAR_PROFILE_CONCAT_INNER(a, b)
+
+#define CLEAR_PROFILE_SCOPE(name) ::clear::ProfileTimer CLEAR_PROFILE_CONCAT(profileTimer, __LINE__)(name)
+#define CLEAR_PROFILE_FUNCTION()  CLEAR_PROFILE_SCOPE(__func__)
+
+// only recorded when the session is detailed, used for fine grained events such as each function's codegen
+#define CLEAR_PROFILE_DETAIL_SCOPE(name) ::clear::ProfileTimer CLEAR_PROFILE_CONCAT(profileTimer, __LINE__)(name, "detail", ::clear::Profiler::IsDetailed())
\ No newline at end of file
@@ -1,20 +1,102 @@
-#pragma once 
+#pragma once
 
 #include "Log.h"
+#include "Arena.h"
 
 #include <memory>
+#include <atomic>
+#include <new>
 
 namespace clear {
 
-    template<typename Type>
+    // counts only touched by one thread at a time, the default
+    struct NonAtomicRefCount
+    {
+        using Count = size_t;
+
+        static inline void   Increment(Count& count) { count++; }
+        static inline size_t Decrement(Count& count) { return --count; }
+        static inline size_t Load(const Count& count) { return count; }
+
+        static inline bool IncrementIfNotZero(Count& count)
+        {
+            if (count == 0)
+                return false;
+
+            count++;
+            return true;
+        }
+    };
+
+    // for objects shared between threads, the thread dropping the last reference sees every write made
+    // through the others before it destroys the object
+    struct AtomicRefCount
+    {
+        using Count = std::atomic<size_t>;
+
+        static inline void   Increment(Count& count) { count.fetch_add(1, std::memory_order_relaxed); }
+        static inline size_t Decrement(Count& count) { return count.fetch_sub(1, std::memory_order_acq_rel) - 1; }
+        static inline size_t Load(const Count& count) { return count.load(std::memory_order_acquire); }
+
+        static inline bool IncrementIfNotZero(Count& count)
+        {
+            size_t current = count.load(std::memory_order_relaxed);
+
+            while (current != 0)
+            {
+                if (count.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+                    return true;
+            }
+
+            return false;
+        }
+    };
+
+    // shared by every Ref and WeakRef of an object. the strong refs together hold one weak count, so the block
+    // outlives the object for as long as a WeakRef can still look at it
+    template<typename Policy>
+    struct RefControlBlock
+    {
+        typename Policy::Count Strong{ 0 };
+        typename Policy::Count Weak{ 1 };
+
+        // both null when an arena owns the object, the arena destroys it and frees the block
+        void (*DestroyObject)(RefControlBlock*) = nullptr;
+        void (*Free)(RefControlBlock*) = nullptr;
+
+        inline bool IsArenaOwned() const { return !DestroyObject; }
+
+        inline void ReleaseWeak()
+        {
+            if (Policy::Decrement(Weak) == 0 && Free)
+                Free(this);
+        }
+    };
+
+    // the object is placed right behind its control block, one allocation like std::make_shared
+    template<typename Type, typename Policy>
+    struct RefStorage
+    {
+        RefControlBlock<Policy> Block;
+        alignas(Type) unsigned char Object[sizeof(Type)];
+
+        inline Type* GetObject() { return std::launder(reinterpret_cast<Type*>(Object)); }
+    };
+
+    template<typename Type, typename Policy>
+    class WeakRef;
+
+    template<typename Type, typename Policy = NonAtomicRefCount>
     class Ref
     {
     public:
+        using ControlBlock = RefControlBlock<Policy>;
+
         Ref() = default;
-        Ref(Type* ptr, size_t* refCount)
-            : m_Ptr(ptr), m_RefCount(refCount)
+        Ref(Type* ptr, ControlBlock* block)
+            : m_Ptr(ptr), m_Block(block)
         {
-            CLEAR_ASSERT(m_Ptr && m_RefCount, "m_Ptr/m_RefCount assigned to null");
+            CLEAR_ASSERT(m_Ptr && m_Block, "m_Ptr/m_Block assigned to null");
             Incref();
         }
         ~Ref()
@@ -23,16 +105,18 @@ namespace clear {
         }
 
         template<typename OtherType>
-        Ref(const Ref<OtherType>& other)
-            : m_Ptr(other.Get()), m_RefCount(other.GetRefCount())
+        Ref(const Ref<OtherType, Policy>& other)
+            : m_Ptr(other.Get()), m_Block(other.GetControlBlock())
         {
-            Incref();
+            if (m_Ptr)
+                Incref();
         }
 
         Ref(const Ref& other)
-            : m_Ptr(other.m_Ptr), m_RefCount(other.m_RefCount)
+            : m_Ptr(other.m_Ptr), m_Block(other.m_Block)
         {
-            Incref();
+            if (m_Ptr)
+                Incref();
         }
 
         Ref& operator=(const Ref& other)
@@ -42,19 +126,20 @@ namespace clear {
                 Decref();
 
                 m_Ptr = other.m_Ptr;
-                m_RefCount = other.m_RefCount;
+                m_Block = other.m_Block;
 
-                Incref();
+                if (m_Ptr)
+                    Incref();
             }
 
             return *this;
         }
 
         Ref(Ref&& other) noexcept
-            : m_Ptr(other.m_Ptr), m_RefCount(other.m_RefCount)
+            : m_Ptr(other.m_Ptr), m_Block(other.m_Block)
         {
             other.m_Ptr = nullptr;
-            other.m_RefCount = nullptr;
+            other.m_Block = nullptr;
         }
 
         Ref& operator=(Ref&& other) noexcept
@@ -64,40 +149,41 @@ namespace clear {
                 Decref();
 
                 m_Ptr = other.m_Ptr;
-                m_RefCount = other.m_RefCount;
+                m_Block = other.m_Block;
                 other.m_Ptr = nullptr;
-                other.m_RefCount = nullptr;
+                other.m_Block = nullptr;
             }
 
             return *this;
         }
 
         inline Type* Get() const { return m_Ptr; }
-        inline size_t GetCount() const { return *m_RefCount; }
-        inline size_t* GetRefCount() const { return m_RefCount; }
+        inline size_t GetCount() const { return m_Block ? Policy::Load(m_Block->Strong) : 0; }
+        inline ControlBlock* GetControlBlock() const { return m_Block; }
 
         inline void Incref()
         {
-            CLEAR_ASSERT(m_RefCount, "ref count was null");
-            (*m_RefCount)++;
+            CLEAR_ASSERT(m_Block, "control block was null");
+            Policy::Increment(m_Block->Strong);
         }
         inline void Decref()
         {
             if (!m_Ptr)
             {
-                CLEAR_ASSERT(!m_RefCount, "ref count wasn't deleted with ptr");
+                CLEAR_ASSERT(!m_Block, "control block wasn't released with ptr");
                 return;
             }
 
-            if (--(*m_RefCount) == 0)
-            {
-                delete m_Ptr;
-                delete m_RefCount;
+            ControlBlock* block = m_Block;
 
-                m_Ptr = nullptr;
-                m_RefCount = nullptr;
-            }
+            m_Ptr = nullptr;
+            m_Block = nullptr;
 
+            if (Policy::Decrement(block->Strong) == 0 && !block->IsArenaOwned())
+            {
+                block->DestroyObject(block);
+                block->ReleaseWeak();
+            }
         }
         inline void Reset()
         {
@@ -110,28 +196,178 @@ namespace clear {
         inline operator bool() const { return Get() != nullptr; }
 
         template<typename ...Args>
-        static Ref<Type> Create(Args&&... args)
+        static Ref<Type, Policy> Create(Args&&... args)
         {
-            size_t* refCount = new size_t(0);
-            Type* object = new Type(std::forward<Args>(args)...);
+            using Storage = RefStorage<Type, Policy>;
 
-            return Ref<Type>(object, refCount);
+            Storage* storage = new Storage;
+
+            try
+            {
+                new (storage->Object) Type(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                delete storage;
+                throw;
+            }
+
+            storage->Block.DestroyObject = [](ControlBlock* block) { reinterpret_cast<Storage*>(block)->GetObject()->~Type(); };
+            storage->Block.Free = [](ControlBlock* block) { delete reinterpret_cast<Storage*>(block); };
+
+            return Ref<Type, Policy>(storage->GetObject(), &storage->Block);
         }
-        
-        template<typename To, typename From>
-        static Ref<To> DynamicCast(const Ref<From>& other)
+
+        // the block and the object are bumped from the arena, both are freed together with it
+        template<typename ...Args>
+        static Ref<Type, Policy> CreateIn(Arena& arena, Args&&... args)
         {
-            const auto ptr = dynamic_cast<To*>(other.Get());
+            ControlBlock* block = arena.Create<ControlBlock>();
+            Type* object = arena.Create<Type>(std::forward<Args>(args)...);
+
+            return Ref<Type, Policy>(object, block);
+        }
+
+    private:
+        Type* m_Ptr = nullptr;
+        ControlBlock* m_Block = nullptr;
+    };
+
+    // casts between refs the way llvm's isa, cast and dyn_cast do, To::classof(From*) says whether the object is a
+    // To. nothing goes through rtti, so the compiler can be built without it like llvm usually is
+    template<typename To, typename From, typename Policy>
+    inline bool Isa(const Ref<From, Policy>& ref)
+    {
+        CLEAR_ASSERT(ref, "isa on a null ref");
+        return To::classof(ref.Get());
+    }
 
-            if (ptr)
-                return Ref<To>(ptr, other.m_RefCount);
+    template<typename To, typename From, typename Policy>
+    inline Ref<To, Policy> Cast(const Ref<From, Policy>& ref)
+    {
+        CLEAR_ASSERT(Isa<To>(ref), "cast to an incompatible type");
+        return Ref<To, Policy>(static_cast<To*>(ref.Get()), ref.GetControlBlock());
+    }
 
+    // an empty ref when the object isn't a To
+    template<typename To, typename From, typename Policy>
+    inline Ref<To, Policy> DynCast(const Ref<From, Policy>& ref)
+    {
+        if (!ref || !To::classof(ref.Get()))
             return {};
+
+        return Ref<To, Policy>(static_cast<To*>(ref.Get()), ref.GetControlBlock());
+    }
+
+    // refers to an object without keeping it alive, for back references like a node's parent that would
+    // otherwise form a cycle with the parent's children and never be freed
+    template<typename Type, typename Policy = NonAtomicRefCount>
+    class WeakRef
+    {
+    public:
+        using ControlBlock = RefControlBlock<Policy>;
+
+        WeakRef() = default;
+
+        template<typename OtherType>
+        WeakRef(const Ref<OtherType, Policy>& ref)
+            : m_Ptr(ref.Get()), m_Block(ref.GetControlBlock())
+        {
+            if (m_Block)
+                Policy::Increment(m_Block->Weak);
+        }
+
+        WeakRef(const WeakRef& other)
+            : m_Ptr(other.m_Ptr), m_Block(other.m_Block)
+        {
+            if (m_Block)
+                Policy::Increment(m_Block->Weak);
+        }
+
+        WeakRef& operator=(const WeakRef& other)
+        {
+            if (this != &other)
+            {
+                Reset();
+
+                m_Ptr = other.m_Ptr;
+                m_Block = other.m_Block;
+
+                if (m_Block)
+                    Policy::Increment(m_Block->Weak);
+            }
+
+            return *this;
+        }
+
+        WeakRef(WeakRef&& other) noexcept
+            : m_Ptr(other.m_Ptr), m_Block(other.m_Block)
+        {
+            other.m_Ptr = nullptr;
+            other.m_Block = nullptr;
+        }
+
+        WeakRef& operator=(WeakRef&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+
+                m_Ptr = other.m_Ptr;
+                m_Block = other.m_Block;
+                other.m_Ptr = nullptr;
+                other.m_Block = nullptr;
+            }
+
+            return *this;
+        }
+
+        ~WeakRef()
+        {
+            Reset();
+        }
+
+        // an arena's objects live as long as the arena, which has to outlive every reference into it anyway
+        inline bool IsExpired() const
+        {
+            return !m_Block || (!m_Block->IsArenaOwned() && Policy::Load(m_Block->Strong) == 0);
+        }
+
+        // a strong reference, or an empty one once the object is gone
+        Ref<Type, Policy> Lock() const
+        {
+            if (!m_Block)
+                return {};
+
+            if (m_Block->IsArenaOwned())
+                return Ref<Type, Policy>(m_Ptr, m_Block);
+
+            if (!Policy::IncrementIfNotZero(m_Block->Strong))
+                return {};
+
+            // the count was taken above, the ref adopts it
+            Ref<Type, Policy> ref(m_Ptr, m_Block);
+            Policy::Decrement(m_Block->Strong);
+
+            return ref;
+        }
+
+        void Reset()
+        {
+            if (!m_Block)
+                return;
+
+            ControlBlock* block = m_Block;
+
+            m_Ptr = nullptr;
+            m_Block = nullptr;
+
+            block->ReleaseWeak();
         }
 
     private:
         Type* m_Ptr = nullptr;
-        size_t* m_RefCount = nullptr;
+        ControlBlock* m_Block = nullptr;
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include "Scan.h"
+#include "ScanKernels.h"
+
+#include "Log.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define CLEAR_SCAN_SSE2
+    #include <emmintrin.h>
+    #ifdef _MSC_VER
+        #include <immintrin.h> // _xgetbv
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define CLEAR_SCAN_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace clear {
+
+#ifdef CLEAR_SCAN_SSE2
+    // sse2 is part of x86-64 so it needs no check
+    struct SSE2Vector
+    {
+        using Vec = __m128i;
+        static constexpr uint32_t Width = 16;
+
+        static Vec Load(const char* data)         { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)); }
+        static Vec Splat(char c)                  { return _mm_set1_epi8(c); }
+        static Vec Equal(Vec v, char c)           { return _mm_cmpeq_epi8(v, Splat(c)); }
+        static Vec Or(Vec a, Vec b)               { return _mm_or_si128(a, b); }
+        static Vec Not(Vec v)                     { return _mm_xor_si128(v, _mm_set1_epi8(-1)); }
+
+        // unsigned v - lo <= hi - lo, saturating subtraction leaves zero exactly for the lanes in range
+        static Vec InRange(Vec v, char lo, char hi)
+        {
+            const Vec offset = _mm_sub_epi8(v, Splat(lo));
+            return _mm_cmpeq_epi8(_mm_subs_epu8(offset, Splat(char(hi - lo))), _mm_setzero_si128());
+        }
+
+        static uint32_t FirstSet(Vec mask)
+        {
+            const uint32_t bits = uint32_t(_mm_movemask_epi8(mask));
+            return bits ? CountTrailingZeros(bits) : Width;
+        }
+
+        static void Leave() {}
+    };
+#endif
+
+#ifdef CLEAR_SCAN_NEON
+    // neon is part of aarch64 so it needs no check
+    struct NEONVector
+    {
+        using Vec = uint8x16_t;
+        static constexpr uint32_t Width = 16;
+
+        static Vec Load(const char* data)         { return vld1q_u8(reinterpret_cast<const uint8_t*>(data)); }
+        static Vec Splat(char c)                  { return vdupq_n_u8(uint8_t(c)); }
+        static Vec Equal(Vec v, char c)           { return vceqq_u8(v, Splat(c)); }
+        static Vec Or(Vec a, Vec b)               { return vorrq_u8(a, b); }
+        static Vec Not(Vec v)                     { return vmvnq_u8(v); }
+
+        static Vec InRange(Vec v, char lo, char hi)
+        {
+            return vcleq_u8(vsubq_u8(v, Splat(lo)), Splat(char(hi - lo)));
+        }
+
+        // neon has no movemask, narrowing every 16 bit lane by 4 leaves 4 bits per byte
+        static uint32_t FirstSet(Vec mask)
+        {
+            const uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(mask), 4)), 0);
+            return bits ? CountTrailingZeros64(bits) / 4 : Width;
+        }
+
+        static void Leave() {}
+    };
+#endif
+
+    static constexpr ScanFunctions s_ScalarFunctions = {
+        &ScanScalar<LineEndMatcher>,
+        &ScanScalar<CommentEndMatcher>,
+        &ScanScalar<StringEndMatcher>,
+        &ScanScalar<NotSpaceMatcher>,
+        &ScanScalar<NotVarNameMatcher>
+    };
+
+#ifdef CLEAR_SCAN_SSE2
+    static constexpr ScanFunctions s_SSE2Functions = MakeScanFunctions<SSE2Vector>();
+#endif
+
+#ifdef CLEAR_SCAN_NEON
+    static constexpr ScanFunctions s_NEONFunctions = MakeScanFunctions<NEONVector>();
+#endif
+
+    static bool HasAVX2()
+    {
+#if defined(CLEAR_SCAN_SSE2) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+
+        // the os has to save the ymm registers as well
+        const bool avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6;
+
+        if (!avx)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#elif defined(CLEAR_SCAN_SSE2)
+        // this can run during static initialization, before the runtime has filled in the cpu model
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+
+    static const ScanFunctions* GetScanFunctions(ScanLevel level)
+    {
+        switch (level)
+        {
+            case ScanLevel::Scalar: return &s_ScalarFunctions;
+#ifdef CLEAR_SCAN_SSE2
+            case ScanLevel::SSE2:   return &s_SSE2Functions;
+            case ScanLevel::AVX2:   return HasAVX2() ? GetAVX2ScanFunctions() : nullptr;
+#endif
+#ifdef CLEAR_SCAN_NEON
+            case ScanLevel::NEON:   return &s_NEONFunctions;
+#endif
+            default:
+                break;
+        }
+
+        return nullptr;
+    }
+
+    ScanLevel GetBestScanLevel()
+    {
+        for (ScanLevel level : { ScanLevel::AVX2, ScanLevel::NEON, ScanLevel::SSE2 })
+        {
+            if (GetScanFunctions(level))
+                return level;
+        }
+
+        return ScanLevel::Scalar;
+    }
+
+    static ScanLevel s_ScanLevel = GetBestScanLevel();
+    static const ScanFunctions* s_ScanFunctions = GetScanFunctions(s_ScanLevel);
+
+    ScanLevel GetScanLevel()
+    {
+        return s_ScanLevel;
+    }
+
+    void SetScanLevel(ScanLevel level)
+    {
+        const ScanFunctions* functions = GetScanFunctions(level);
+        CLEAR_VERIFY(functions, ScanLevelToString(level), " scanning is not supported on this cpu");
+
+        s_ScanLevel = level;
+        s_ScanFunctions = functions;
+    }
+
+    const char* ScanLevelToString(ScanLevel level)
+    {
+        switch (level)
+        {
+            case ScanLevel::Scalar: return "scalar";
+            case ScanLevel::SSE2:   return "sse2";
+            case ScanLevel::AVX2:   return "avx2";
+            case ScanLevel::NEON:   return "neon";
+            default:
+                break;
+        }
+
+        return "";
+    }
+
+    size_t FindLineEnd(std::string_view text, size_t start)
+    {
+        return s_ScanFunctions->FindLineEnd(text.data(), text.size(), start);
+    }
+
+    size_t FindCommentEnd(std::string_view text, size_t start)
+    {
+        return s_ScanFunctions->FindCommentEnd(text.data(), text.size(), start);
+    }
+
+    size_t FindStringEnd(std::string_view text, size_t start)
+    {
+        return s_ScanFunctions->FindStringEnd(text.data(), text.size(), start);
+    }
+
+    size_t SkipSpaces(std::string_view text, size_t start)
+    {
+        return s_ScanFunctions->SkipSpaces(text.data(), text.size(), start);
+    }
+
+    size_t SkipVarName(std::string_view text, size_t start)
+    {
+        return s_ScanFunctions->SkipVarName(text.data(), text.size(), start);
+    }
+
+}
\ No newline at end of file
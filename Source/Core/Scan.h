@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string_view>
+#include <cstddef>
+
+namespace clear {
+
+    // the instruction set the scanning functions below use, the best one the cpu supports is picked at startup
+    enum class ScanLevel
+    {
+        Scalar = 0,
+        SSE2,
+        AVX2,
+        NEON
+    };
+
+    extern ScanLevel GetScanLevel();
+    extern ScanLevel GetBestScanLevel();
+    extern void SetScanLevel(ScanLevel level);
+    extern const char* ScanLevelToString(ScanLevel level);
+
+    // each returns the offset of the first character at or after start that ends the scan,
+    // text.size() if there is none and start if start is already past the end
+    extern size_t FindLineEnd(std::string_view text, size_t start);    // '\n' or '\0'
+    extern size_t FindCommentEnd(std::string_view text, size_t start); // '*' or '\0'
+    extern size_t FindStringEnd(std::string_view text, size_t start);  // '"', '\\', '\n' or '\0'
+    extern size_t SkipSpaces(std::string_view text, size_t start);     // anything but ' ' and '\t'
+    extern size_t SkipVarName(std::string_view text, size_t start);    // anything but alphanumerics and '_'
+
+}
\ No newline at end of file
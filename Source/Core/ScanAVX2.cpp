@@ -0,0 +1,54 @@
+#include "ScanKernels.h"
+
+// this file is built with avx2 enabled (see CMakeLists.txt), Scan.cpp only calls into it after checking the cpu.
+// msvc allows avx2 intrinsics without enabling them for the whole file
+#if defined(__AVX2__) || (defined(_MSC_VER) && defined(_M_X64))
+    #define CLEAR_SCAN_AVX2
+    #include <immintrin.h>
+#endif
+
+namespace clear {
+
+#ifdef CLEAR_SCAN_AVX2
+    struct AVX2Vector
+    {
+        using Vec = __m256i;
+        static constexpr uint32_t Width = 32;
+
+        static Vec Load(const char* data)         { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data)); }
+        static Vec Splat(char c)                  { return _mm256_set1_epi8(c); }
+        static Vec Equal(Vec v, char c)           { return _mm256_cmpeq_epi8(v, Splat(c)); }
+        static Vec Or(Vec a, Vec b)               { return _mm256_or_si256(a, b); }
+        static Vec Not(Vec v)                     { return _mm256_xor_si256(v, _mm256_set1_epi8(-1)); }
+
+        static Vec InRange(Vec v, char lo, char hi)
+        {
+            const Vec offset = _mm256_sub_epi8(v, Splat(lo));
+            return _mm256_cmpeq_epi8(_mm256_subs_epu8(offset, Splat(char(hi - lo))), _mm256_setzero_si256());
+        }
+
+        static uint32_t FirstSet(Vec mask)
+        {
+            const uint32_t bits = uint32_t(_mm256_movemask_epi8(mask));
+            return bits ? CountTrailingZeros(bits) : Width;
+        }
+
+        // the rest of the lexer is built for sse, leaving the upper halves of the ymm registers dirty makes every
+        // sse instruction after this wait on them. compilers don't always insert this when optimizations are low
+        static void Leave() { _mm256_zeroupper(); }
+    };
+
+    static constexpr ScanFunctions s_AVX2Functions = MakeScanFunctions<AVX2Vector>();
+
+    const ScanFunctions* GetAVX2ScanFunctions()
+    {
+        return &s_AVX2Functions;
+    }
+#else
+    const ScanFunctions* GetAVX2ScanFunctions()
+    {
+        return nullptr;
+    }
+#endif
+
+}
\ No newline at end of file
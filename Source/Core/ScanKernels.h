@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+namespace clear {
+
+    struct ScanFunctions
+    {
+        size_t (*FindLineEnd)(const char* data, size_t size, size_t start);
+        size_t (*FindCommentEnd)(const char* data, size_t size, size_t start);
+        size_t (*FindStringEnd)(const char* data, size_t size, size_t start);
+        size_t (*SkipSpaces)(const char* data, size_t size, size_t start);
+        size_t (*SkipVarName)(const char* data, size_t size, size_t start);
+    };
+
+    // defined in ScanAVX2.cpp, which is the only file built with avx2 enabled. null when it wasn't
+    extern const ScanFunctions* GetAVX2ScanFunctions();
+
+    // the loops are shared by every instruction set, each file instantiates them with its own vector type.
+    // everything here has internal linkage so the linker never merges a copy built for avx2 into the baseline code
+    namespace {
+
+        inline uint32_t CountTrailingZeros(uint32_t mask)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return uint32_t(index);
+#else
+            return uint32_t(__builtin_ctz(mask));
+#endif
+        }
+
+        inline uint32_t CountTrailingZeros64(uint64_t mask)
+        {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward64(&index, mask);
+            return uint32_t(index);
+#else
+            return uint32_t(__builtin_ctzll(mask));
+#endif
+        }
+
+        // a matcher says whether a character ends the scan, for one character and for a whole vector at once
+
+        struct LineEndMatcher
+        {
+            static bool Scalar(char c) { return c == '\n' || c == '\0'; }
+
+            template<typename V>
+            static typename V::Vec Vector(typename V::Vec v) { return V::Or(V::Equal(v, '\n'), V::Equal(v, '\0')); }
+        };
+
+        struct CommentEndMatcher
+        {
+            static bool Scalar(char c) { return c == '*' || c == '\0'; }
+
+            template<typename V>
+            static typename V::Vec Vector(typename V::Vec v) { return V::Or(V::Equal(v, '*'), V::Equal(v, '\0')); }
+        };
+
+        struct StringEndMatcher
+        {
+            static bool Scalar(char c) { return c == '"' || c == '\\' || c == '\n' || c == '\0'; }
+
+            template<typename V>
+            static typename V::Vec Vector(typename V::Vec v)
+            {
+                return V::Or(V::Or(V::Equal(v, '"'), V::Equal(v, '\\')), V::Or(V::Equal(v, '\n'), V::Equal(v, '\0')));
+            }
+        };
+
+        struct NotSpaceMatcher
+        {
+            static bool Scalar(char c) { return c != ' ' && c != '\t'; }
+
+            template<typename V>
+            static typename V::Vec Vector(typename V::Vec v) { return V::Not(V::Or(V::Equal(v, ' '), V::Equal(v, '\t'))); }
+        };
+
+        struct NotVarNameMatcher
+        {
+            static bool Scalar(char c)
+            {
+                const char lower = char(c | 0x20);
+                return !((lower >= 'a' && lower <= 'z') || (c >= '0' && c <= '9') || c == '_');
+            }
+
+            template<typename V>
+            static typename V::Vec Vector(typename V::Vec v)
+            {
+                // setting 0x20 folds upper case onto lower case
+                const typename V::Vec letter = V::InRange(V::Or(v, V::Splat(0x20)), 'a', 'z');
+                return V::Not(V::Or(V::Or(letter, V::InRange(v, '0', '9')), V::Equal(v, '_')));
+            }
+        };
+
+        template<typename M>
+        size_t ScanScalar(const char* data, size_t size, size_t start)
+        {
+            size_t i = start;
+
+            while (i < size && !M::Scalar(data[i]))
+                i++;
+
+            return i;
+        }
+
+        // most identifiers and runs of spaces are only a few characters long, they end before a vector would pay off
+        static constexpr size_t s_ScalarPrefix = 8;
+
+        template<typename V, typename M>
+        size_t ScanVector(const char* data, size_t size, size_t start)
+        {
+            size_t i = start;
+
+            for (const size_t prefixEnd = start + s_ScalarPrefix; i < size && i < prefixEnd; i++)
+            {
+                if (M::Scalar(data[i]))
+                    return i;
+            }
+
+            for (; i + V::Width <= size; i += V::Width)
+            {
+                const uint32_t index = V::FirstSet(M::template Vector<V>(V::Load(data + i)));
+
+                if (index < V::Width)
+                {
+                    V::Leave();
+                    return i + index;
+                }
+            }
+
+            V::Leave();
+
+            // the tail is shorter than a vector
+            return ScanScalar<M>(data, size, i);
+        }
+
+        template<typename V>
+        constexpr ScanFunctions MakeScanFunctions()
+        {
+            return {
+                &ScanVector<V, LineEndMatcher>,
+                &ScanVector<V, CommentEndMatcher>,
+                &ScanVector<V, StringEndMatcher>,
+                &ScanVector<V, NotSpaceMatcher>,
+                &ScanVector<V, NotVarNameMatcher>
+            };
+        }
+
+    }
+
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Log.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+
+namespace clear {
+
+    // appends plain values to a byte string in host byte order, it is only read back by the same build
+    class BinaryWriter
+    {
+    public:
+        BinaryWriter(std::string& data)
+            : m_Data(data)
+        {
+        }
+
+        template<typename T>
+        void Write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "only plain values can be written directly");
+            m_Data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        void WriteString(std::string_view value)
+        {
+            Write<uint32_t>((uint32_t)value.size());
+            m_Data.append(value);
+        }
+
+        template<typename T>
+        void WriteArray(const std::vector<T>& values)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "only plain values can be written directly");
+
+            Write<uint64_t>(values.size());
+            m_Data.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+        }
+
+        size_t GetSize() const { return m_Data.size(); }
+
+    private:
+        std::string& m_Data;
+    };
+
+    // reads what a BinaryWriter wrote, the data is checked before it is handed to a reader so running past
+    // the end means the layout of a writer and its reader disagree
+    class BinaryReader
+    {
+    public:
+        BinaryReader(std::string_view data)
+            : m_Data(data)
+        {
+        }
+
+        template<typename T>
+        T Read()
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "only plain values can be read directly");
+
+            T value;
+            std::memcpy(&value, _Take(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        std::string_view ReadString()
+        {
+            const size_t size = Read<uint32_t>();
+            return std::string_view(_Take(size), size);
+        }
+
+        template<typename T>
+        void ReadArray(std::vector<T>& values)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "only plain values can be read directly");
+
+            const size_t count = Read<uint64_t>();
+            values.resize(count);
+
+            // one copy out of the mapped file
+            std::memcpy(values.data(), _Take(count * sizeof(T)), count * sizeof(T));
+        }
+
+        size_t GetOffset() const { return m_Offset; }
+        bool IsAtEnd() const { return m_Offset == m_Data.size(); }
+
+    private:
+        const char* _Take(size_t size)
+        {
+            CLEAR_VERIFY(size <= m_Data.size() - m_Offset, "read ", size, " bytes past the end of serialized data");
+
+            const char* data = m_Data.data() + m_Offset;
+            m_Offset += size;
+
+            return data;
+        }
+
+    private:
+        std::string_view m_Data;
+        size_t m_Offset = 0;
+    };
+
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "Symbol.h"
+
+#include "Log.h"
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/Support/Allocator.h>
+
+#include <vector>
+
+namespace clear {
+
+    namespace {
+
+        struct SymbolTable
+        {
+            // the map's entries hold the characters, they are bump allocated and never move
+            llvm::StringMap<uint32_t, llvm::BumpPtrAllocator> IDs;
+            std::vector<std::string_view> Strings;
+
+            // (scope, name) pairs that were already joined
+            llvm::DenseMap<std::pair<uint32_t, uint32_t>, uint32_t> Scoped;
+
+            SymbolTable()
+            {
+                Strings.push_back({});
+            }
+        };
+
+        // made on first use, symbols can be created by static initializers
+        SymbolTable& GetTable()
+        {
+            static SymbolTable s_Table;
+            return s_Table;
+        }
+
+        uint32_t Intern(std::string_view string)
+        {
+            if (string.empty())
+                return 0;
+
+            SymbolTable& table = GetTable();
+
+            auto [it, inserted] = table.IDs.try_emplace(llvm::StringRef(string.data(), string.size()), (uint32_t)table.Strings.size());
+
+            if (inserted)
+            {
+                CLEAR_VERIFY(table.Strings.size() < UINT32_MAX, "too many symbols");
+                table.Strings.push_back(std::string_view(it->getKeyData(), it->getKeyLength()));
+            }
+
+            return it->getValue();
+        }
+
+    }
+
+    Symbol::Symbol(std::string_view string)
+        : m_ID(Intern(string))
+    {
+    }
+
+    Symbol::Symbol(Symbol scope, Symbol name)
+    {
+        SymbolTable& table = GetTable();
+
+        const std::pair<uint32_t, uint32_t> key(scope.m_ID, name.m_ID);
+        auto it = table.Scoped.find(key);
+
+        if (it != table.Scoped.end())
+        {
+            m_ID = it->second;
+            return;
+        }
+
+        std::string joined;
+        joined.reserve(scope.GetString().size() + name.GetString().size() + 2);
+        joined.append(scope.GetString()).append("::").append(name.GetString());
+
+        m_ID = Intern(joined);
+        table.Scoped[key] = m_ID;
+    }
+
+    std::string_view Symbol::GetString() const
+    {
+        return GetTable().Strings[m_ID];
+    }
+
+    size_t Symbol::GetCount()
+    {
+        return GetTable().Strings.size() - 1;
+    }
+
+}
\ No newline at end of file
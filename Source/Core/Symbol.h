@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <functional>
+#include <cstdint>
+
+namespace clear {
+
+    // an interned string. the characters are kept once in an arena for the rest of the process and symbols are
+    // compared and hashed by their id. symbols are made while the ast is built, which happens on one thread
+    class Symbol
+    {
+    public:
+        Symbol() = default; // the empty string
+        explicit Symbol(std::string_view string);
+
+        // the symbol of "scope::name", the joined string is only built the first time the pair is seen
+        Symbol(Symbol scope, Symbol name);
+
+        std::string_view GetString() const;
+        inline uint32_t GetID() const { return m_ID; }
+        inline bool IsEmpty() const { return m_ID == 0; }
+
+        inline bool operator==(const Symbol& other) const { return m_ID == other.m_ID; }
+        inline bool operator!=(const Symbol& other) const { return m_ID != other.m_ID; }
+
+        // the number of distinct strings interned so far
+        static size_t GetCount();
+
+    private:
+        uint32_t m_ID = 0;
+    };
+
+}
+
+template<>
+struct std::hash<clear::Symbol>
+{
+    size_t operator()(const clear::Symbol& symbol) const { return std::hash<uint32_t>()(symbol.GetID()); }
+};
\ No newline at end of file
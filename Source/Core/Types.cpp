@@ -59,23 +59,42 @@ namespace clear {
 		}
 	}
 
-	llvm::Value* GetLLVMConstant(VariableType type, const std::string& data)
+	llvm::Value* GetLLVMConstant(VariableType type, const NumberLiteral& literal)
 	{
 		auto& context = *LLVM::Backend::GetContext();
 
+		// a literal can be passed where a type of another width or kind is expected
+		auto getInteger = [&](uint32_t bits, bool isSigned)
+			{
+				uint64_t value = literal.Value;
+
+				if (literal.IsFloatingPoint)
+					value = isSigned ? (uint64_t)(int64_t)literal.GetFloat() : (uint64_t)literal.GetFloat();
+
+				return llvm::ConstantInt::get(context, llvm::APInt(64, value).trunc(bits));
+			};
+
+		auto getFloat = [&]()
+			{
+				if (literal.IsFloatingPoint)
+					return literal.GetFloat();
+
+				return literal.IsSigned ? (double)(int64_t)literal.Value : (double)literal.Value;
+			};
+
 		switch (type)
 		{
-			case VariableType::Int8:    return llvm::ConstantInt::get(llvm::Type::getInt8Ty(context),  (int8_t)std::stoi(data),     true);
-			case VariableType::Int16:   return llvm::ConstantInt::get(llvm::Type::getInt16Ty(context), (int16_t)std::stoi(data),    true);
-			case VariableType::Int32:   return llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), (int32_t)std::stoi(data),    true);
-			case VariableType::Int64:   return llvm::ConstantInt::get(llvm::Type::getInt64Ty(context), (int64_t)std::stoll(data),   true);
-			case VariableType::Uint8:   return llvm::ConstantInt::get(llvm::Type::getInt8Ty(context),  (uint8_t)std::stoull(data),  false);
-			case VariableType::Uint16:  return llvm::ConstantInt::get(llvm::Type::getInt16Ty(context), (uint16_t)std::stoull(data), false);
-			case VariableType::Uint32:  return llvm::ConstantInt::get(llvm::Type::getInt32Ty(context), (uint32_t)std::stoull(data), false);
-			case VariableType::Uint64:  return llvm::ConstantInt::get(llvm::Type::getInt64Ty(context), (uint64_t)std::stoull(data), false);
-			case VariableType::Float32: return llvm::ConstantFP::get(llvm::Type::getFloatTy(context),  (float)std::stod(data));
-			case VariableType::Float64: return llvm::ConstantFP::get(llvm::Type::getDoubleTy(context), (double)std::stod(data));
-			case VariableType::Bool:	return llvm::ConstantInt::get(llvm::Type::getInt1Ty(context),  data == "true" ? 1 : 0);
+			case VariableType::Int8:    return getInteger(8,  true);
+			case VariableType::Int16:   return getInteger(16, true);
+			case VariableType::Int32:   return getInteger(32, true);
+			case VariableType::Int64:   return getInteger(64, true);
+			case VariableType::Uint8:   return getInteger(8,  false);
+			case VariableType::Uint16:  return getInteger(16, false);
+			case VariableType::Uint32:  return getInteger(32, false);
+			case VariableType::Uint64:  return getInteger(64, false);
+			case VariableType::Float32: return llvm::ConstantFP::get(llvm::Type::getFloatTy(context),  (float)getFloat());
+			case VariableType::Float64: return llvm::ConstantFP::get(llvm::Type::getDoubleTy(context), getFloat());
+			case VariableType::Bool:	return llvm::ConstantInt::get(llvm::Type::getInt1Ty(context),  literal.Value != 0 ? 1 : 0);
 			case VariableType::None:
 			default:
 				return nullptr;
@@ -153,7 +172,7 @@ namespace clear {
 	}
 
 	AbstractType::AbstractType(const Token& token)
-		: m_Type(GetVariableTypeFromTokenType(token.TokenType)), m_LLVMType(GetLLVMVariableType(m_Type))
+		: m_Type(GetVariableTypeFromTokenType(token.TokenType))
 	{
 		if (token.TokenType == TokenType::RValueNumber ||
 			token.TokenType == TokenType::RValueChar ||
@@ -169,7 +188,7 @@ namespace clear {
 	}
 
 	AbstractType::AbstractType(const Token& token, TypeKind kind)
-		: m_Type(GetVariableTypeFromTokenType(token.TokenType)), m_LLVMType(GetLLVMVariableType(m_Type)), m_Kind(kind)
+		: m_Type(GetVariableTypeFromTokenType(token.TokenType)), m_Kind(kind)
 	{
 		if (token.TokenType == TokenType::RValueNumber ||
 			token.TokenType == TokenType::RValueChar ||
@@ -185,7 +204,7 @@ namespace clear {
 	}
 
 	AbstractType::AbstractType(VariableType type, TypeKind kind, const std::string& userDefinedtype)
-		: m_Type(type), m_LLVMType(GetLLVMVariableType(type)), m_UserDefinedType(userDefinedtype), m_Kind(kind)
+		: m_Type(type), m_UserDefinedType(userDefinedtype), m_Kind(kind)
 	{
 	}
 
@@ -193,59 +212,62 @@ namespace clear {
 		: m_Kind(TypeKind::RValue)
 	{
 		//handle the case where the type may be a number
-		NumberInfo info = GetNumberInfoFromLiteral(value);
-		
-		if (info.Valid) 
+		NumberLiteral literal = DecodeNumberLiteral(value);
+
+		if (!literal.Valid)
+			literal = DecodeBoolLiteral(value);
+
+		if (literal.Valid)
+			m_Type = AbstractType(literal).Get();
+		else
+			m_Type = VariableType::Array;
+
+		CLEAR_VERIFY(m_Type != VariableType::None, "could not evaluate type of ", value);
+	}
+
+	AbstractType::AbstractType(const NumberLiteral& literal)
+		: m_Kind(TypeKind::RValue)
+	{
+		if (literal.BitsNeeded == 1)
 		{
-			if (info.IsSigned && !info.IsFloatingPoint)
-			{
-				switch (info.BitsNeeded)
-				{
-					case 8:  m_Type = VariableType::Int8;  break;
-					case 16: m_Type = VariableType::Int16; break;
-					case 32: m_Type = VariableType::Int32; break;
-					case 64: m_Type = VariableType::Int64; break;
-					default:
-						break;
-				}
-			}
-			else if (!info.IsFloatingPoint)
-			{
-				switch (info.BitsNeeded)
-				{
-					case 8:  m_Type = VariableType::Uint8;  break;
-					case 16: m_Type = VariableType::Uint16; break;
-					case 32: m_Type = VariableType::Uint32; break;
-					case 64: m_Type = VariableType::Uint64; break;
-					default:
-						break;
-				}
-			}
-			else 
+			m_Type = VariableType::Bool;
+		}
+		else if (literal.IsSigned && !literal.IsFloatingPoint)
+		{
+			switch (literal.BitsNeeded)
 			{
-				switch (info.BitsNeeded)
-				{
-					case 32: m_Type = VariableType::Float32; break;
-					case 64: m_Type = VariableType::Float64; break;
-					default:
-						break;
-				}
+				case 8:  m_Type = VariableType::Int8;  break;
+				case 16: m_Type = VariableType::Int16; break;
+				case 32: m_Type = VariableType::Int32; break;
+				case 64: m_Type = VariableType::Int64; break;
+				default:
+					break;
 			}
 		}
-		else if (value == "true" || value == "false")
+		else if (!literal.IsFloatingPoint)
 		{
-			m_Type = VariableType::Bool;
+			switch (literal.BitsNeeded)
+			{
+				case 8:  m_Type = VariableType::Uint8;  break;
+				case 16: m_Type = VariableType::Uint16; break;
+				case 32: m_Type = VariableType::Uint32; break;
+				case 64: m_Type = VariableType::Uint64; break;
+				default:
+					break;
+			}
 		}
-		else
+		else 
 		{
-			m_Type = VariableType::Array;
+			switch (literal.BitsNeeded)
+			{
+				case 32: m_Type = VariableType::Float32; break;
+				case 64: m_Type = VariableType::Float64; break;
+				default:
+					break;
+			}
 		}
 
-
-		CLEAR_VERIFY(m_Type != VariableType::None, "could not evaluate type of ", value);
-		m_LLVMType = GetLLVMVariableType(m_Type);
-
-		return;
+		CLEAR_VERIFY(m_Type != VariableType::None, "could not evaluate type of a literal");
 	}
 
 	const bool AbstractType::IsSigned() const
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Parsing/Tokens.h"
+#include "Core/Utils.h"
 #include "API/LLVM/LLVMInclude.h"
 
 #include <variant>
@@ -37,7 +38,7 @@ namespace clear {
 	extern BinaryExpressionType GetBinaryExpressionTypeFromTokenType(TokenType type);
 	extern VariableType	GetVariableTypeFromTokenType(TokenType tokenType);
 	extern llvm::Type*	GetLLVMVariableType(VariableType type);
-	extern llvm::Value*	GetLLVMConstant(VariableType type, const std::string& data);
+	extern llvm::Value*	GetLLVMConstant(VariableType type, const NumberLiteral& literal);
 	extern bool IsTypeIntegral(VariableType type);
 
 	class AbstractType 
@@ -48,14 +49,15 @@ namespace clear {
 		AbstractType(const Token& token, TypeKind kind);
 		AbstractType(VariableType type, TypeKind kind = TypeKind::RValue, const std::string& userDefinedType = "");
 		AbstractType(const std::string_view& value); //auto generate type from a value
+		AbstractType(const NumberLiteral& literal); //the smallest type that holds a decoded literal
 
 		static llvm::Value* CastValue(llvm::Value* casting, AbstractType to);
 
 		inline const VariableType Get() const { return m_Type; };
 		inline const TypeKind GetKind() const { return m_Kind; }
 		inline const std::string& GetUserDefinedType() const { return m_UserDefinedType; }
-		inline const llvm::Type*  GetLLVMType() const { return m_LLVMType; }
-		inline llvm::Type* GetLLVMType() { return m_LLVMType; }
+		// looked up in the current context rather than kept, an ast can outlive the module it was first generated into
+		inline llvm::Type* GetLLVMType() const { return GetLLVMVariableType(m_Type); }
 
 
 		const bool IsFloatingPoint() const;
@@ -76,7 +78,6 @@ namespace clear {
 	private:
 		VariableType m_Type = VariableType::None;
 		TypeKind m_Kind = TypeKind::None;
-		llvm::Type*  m_LLVMType = nullptr;
 		std::string  m_UserDefinedType = "";
 	};
 }
\ No newline at end of file
@@ -1,19 +1,19 @@
 #include "Utils.h"
 
 #include <fast_float/fast_float.h>
-//#include <charconv> replacement
+
+#include <charconv>
+#include <cmath>
 
 #include <string>
 #include <vector>
 #include <sstream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
 
 namespace clear {
 
-    bool IsSpace(char c)
-    {
-        return c == ' ' || c == '\t';
-    }
-
     std::string Str(char hello)
     {
         std::string s(1, hello);
@@ -32,107 +32,105 @@ namespace clear {
 
     }
 
-    int HexStringToInteger(const std::string& hexString)
+    NumberLiteral DecodeNumberLiteral(std::string_view str, uint32_t base)
     {
-        int result = 0;
-        int length = hexString.length();
+        NumberLiteral literal;
 
-        for (int i = 0; i < length; i++) 
-        {
-            char hexChar = hexString[i];
-            int hexValue = 0;
+        const bool negative = base == 10 && !str.empty() && str.front() == '-';
+        const std::string_view digits = negative ? str.substr(1) : str;
 
-            if (hexChar >= '0' && hexChar <= '9') 
-            {
-                hexValue = hexChar - '0';
-            } 
-            else if (hexChar >= 'A' && hexChar <= 'F') 
-            {
-                hexValue = hexChar - 'A' + 10;
-            } 
-            else if (hexChar >= 'a' && hexChar <= 'f') 
+        if (digits.empty() || (base == 10 && !IsDigit(digits.front())))
+            return literal;
+
+        uint64_t magnitude = 0;
+        auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), magnitude, (int)base);
+
+        if (error == std::errc() && end == digits.data() + digits.size())
+        {
+            if (!negative || magnitude == 0)
             {
-                hexValue = hexChar - 'a' + 10;
+                literal.Value = magnitude;
+                literal.BitsNeeded = magnitude <= UINT8_MAX ? 8 : magnitude <= UINT16_MAX ? 16 : magnitude <= UINT32_MAX ? 32 : 64;
+                literal.Valid = true;
+
+                return literal;
             }
 
-            result = result * 16 + hexValue;
+            if (magnitude <= (uint64_t(1) << 63))
+            {
+                literal.Value = 0 - magnitude;
+                literal.BitsNeeded = magnitude <= 0x80 ? 8 : magnitude <= 0x8000 ? 16 : magnitude <= 0x80000000 ? 32 : 64;
+                literal.IsSigned = true;
+                literal.Valid = true;
+
+                return literal;
+            }
         }
-           
-        return result;
-    }
 
-    int BinaryStringToInteger(const std::string& binaryString) 
-    {
-        int result = 0;
-        int length = binaryString.length();
+        // only base 10 literals have fractions and exponents, or are read as a double when too large
+        if (base != 10)
+            return literal;
+
+        double value;
+        auto [floatEnd, floatError] = fast_float::from_chars(str.data(), str.data() + str.size(), value);
+
+        if (floatError != std::errc() || floatEnd != str.data() + str.size())
+            return literal;
+
+        literal.Valid = true;
 
-        for (int i = 0; i < length; i++) 
+        // whole numbers written with an exponent still get an integer type
+        if (value == std::trunc(value) && value >= -9223372036854775808.0 && value < 18446744073709551616.0)
         {
-            if (binaryString[i] == '1') 
-            {
-                result += pow(2, length - i - 1);
-            }
+            if (value >= 0.0)
+                return DecodeNumberLiteral(std::to_string((uint64_t)value));
+
+            return DecodeNumberLiteral(std::to_string((int64_t)value));
         }
 
-        return result;
+        std::memcpy(&literal.Value, &value, sizeof(double));
+        literal.BitsNeeded = (double)(float)value == value ? 32 : 64;
+        literal.IsSigned = true;
+        literal.IsFloatingPoint = true;
+
+        return literal;
     }
 
-    bool IsVarNameChar(char c)
+    NumberLiteral DecodeBoolLiteral(std::string_view str)
     {
-        return std::isalnum(c) || c == '_';
-    }
+        NumberLiteral literal;
 
-	bool IsValidNumber(const std::string_view& str)
-	{
-		double result;
-		auto [ptr, ec] = fast_float::from_chars(str.data(), str.data() + str.size(), result); 
-		return ec == std::errc() && ptr == str.data() + str.size();
-	}
+        if (str != "true" && str != "false")
+            return literal;
 
-    NumberInfo GetNumberInfoFromLiteral(const std::string_view& str)
-    {
-        NumberInfo info;
+        literal.Value = str == "true";
+        literal.BitsNeeded = 1;
+        literal.Valid = true;
 
-        double result;
-        auto [ptr, ec] = fast_float::from_chars(str.data(), str.data() + str.size(), result);
+        return literal;
+    }
 
-        if (ec != std::errc())
-            return info;
+    void ParallelFor(size_t count, uint32_t threads, const std::function<void(size_t)>& function)
+    {
+        uint32_t threadCount = threads ? threads : std::max(std::thread::hardware_concurrency(), 1u);
+        threadCount = (uint32_t)std::min<size_t>(threadCount, count);
 
-        info.Valid = true;
+        std::atomic<size_t> next = 0;
 
-        auto testTypeAgainst = [&info, result](auto type)
+        auto worker = [&]()
             {
-                using T = decltype(type);
-
-                if (result == (double)((T)(result)))
-                {
-                    if constexpr (std::is_signed_v<T>)
-                    {
-                        info.IsSigned = true;
-                    }
-
-                    if constexpr (std::is_floating_point_v<T>)
-                    {
-                        info.IsFloatingPoint = true;
-                    }
-
-                    info.BitsNeeded = sizeof(T) * 8;
-                    return true;
-                }
-                return false;
+                for (size_t i = next++; i < count; i = next++)
+                    function(i);
             };
 
-        if (testTypeAgainst(uint8_t{}) || testTypeAgainst(uint16_t{}) || testTypeAgainst(uint32_t{}) || testTypeAgainst(uint64_t{}))
-            return info;
+        std::vector<std::thread> workers;
+        for (uint32_t i = 1; i < threadCount; i++)
+            workers.emplace_back(worker);
 
-        if (testTypeAgainst(int8_t{}) || testTypeAgainst(int16_t{}) || testTypeAgainst(int32_t{}) || testTypeAgainst(int64_t{}))
-            return info;
+        worker();
 
-        if (testTypeAgainst(float{}) || testTypeAgainst(double{}))
-            return info;
-
-
-        return info;
+        for (auto& worker : workers)
+            worker.join();
     }
+
 }
\ No newline at end of file
@@ -1,26 +1,94 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <array>
+#include <functional>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
 
 namespace clear {
 
-    extern bool IsSpace(char c);
+    enum CharClass : uint8_t
+    {
+        CharClass_None       = 0,
+        CharClass_Space      = 1 << 0, // ' ' and '\t', the only characters skipped between tokens
+        CharClass_Whitespace = 1 << 1, // everything std::isspace accepts
+        CharClass_Digit      = 1 << 2,
+        CharClass_Alpha      = 1 << 3,
+        CharClass_HexDigit   = 1 << 4,
+        CharClass_VarName    = 1 << 5  // alphanumeric or '_'
+    };
+
+    // one lookup per character instead of the locale aware <cctype> functions
+    inline constexpr std::array<uint8_t, 256> g_CharClasses = []()
+        {
+            std::array<uint8_t, 256> classes{};
+
+            for (int c = 0; c < 256; c++)
+            {
+                uint8_t cls = CharClass_None;
+
+                if (c == ' ' || c == '\t')
+                    cls |= CharClass_Space;
+
+                if (c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r')
+                    cls |= CharClass_Whitespace;
+
+                if (c >= '0' && c <= '9')
+                    cls |= CharClass_Digit | CharClass_HexDigit | CharClass_VarName;
+
+                if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+                    cls |= CharClass_Alpha | CharClass_VarName;
+
+                if ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'))
+                    cls |= CharClass_HexDigit;
+
+                if (c == '_')
+                    cls |= CharClass_VarName;
+
+                classes[c] = cls;
+            }
+
+            return classes;
+        }();
+
+    inline constexpr bool HasCharClass(char c, uint8_t cls) { return (g_CharClasses[(uint8_t)c] & cls) != 0; }
+
+    inline constexpr bool IsSpace(char c)        { return HasCharClass(c, CharClass_Space); }
+    inline constexpr bool IsWhitespace(char c)   { return HasCharClass(c, CharClass_Whitespace); }
+    inline constexpr bool IsDigit(char c)        { return HasCharClass(c, CharClass_Digit); }
+    inline constexpr bool IsAlphaNumeric(char c) { return HasCharClass(c, CharClass_Digit | CharClass_Alpha); }
+    inline constexpr bool IsHexDigit(char c)     { return HasCharClass(c, CharClass_HexDigit); }
+    inline constexpr bool IsVarNameChar(char c)  { return HasCharClass(c, CharClass_VarName); }
+
     extern std::string Str(char c);
     extern std::vector<std::string> Split(const std::string& str);
-    extern bool IsVarNameChar(char c);
-    extern bool IsValidNumber(const std::string_view& str);
-    extern int BinaryStringToInteger(const std::string& binaryString);
-    extern int HexStringToInteger(const std::string& hexString);
 
-    struct NumberInfo
+    // a number literal decoded once by the lexer. integers are read exactly rather than through a double, so
+    // values above 2^53 keep every digit. BitsNeeded is the width of the smallest type that holds the value,
+    // 1 for true and false
+    struct NumberLiteral
     {
-        bool Valid = false;
-        bool IsFloatingPoint = false;
+        uint64_t Value = 0; // two's complement when negative, the bits of the double when floating point
+        uint8_t BitsNeeded = 0;
         bool IsSigned = false;
-        size_t BitsNeeded = 0;
+        bool IsFloatingPoint = false;
+        bool Valid = false;
+
+        inline double GetFloat() const { double value; std::memcpy(&value, &Value, sizeof(double)); return value; }
     };
 
-    extern NumberInfo GetNumberInfoFromLiteral(const std::string_view& str);
+    static_assert(sizeof(NumberLiteral) == 16 && std::is_trivially_copyable_v<NumberLiteral>, "number literals are stored in the payload arena as is");
+
+    // str is the literal without its 0x/0b prefix when base isn't 10, only base 10 literals can have a sign,
+    // a fraction or an exponent
+    extern NumberLiteral DecodeNumberLiteral(std::string_view str, uint32_t base = 10);
+    extern NumberLiteral DecodeBoolLiteral(std::string_view str);
+
+    // calls function(i) for every i below count on up to threads threads, 0 uses one per hardware thread
+    extern void ParallelFor(size_t count, uint32_t threads, const std::function<void(size_t)>& function);
 
 }
\ No newline at end of file
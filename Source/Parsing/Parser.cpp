@@ -1,4 +1,5 @@
 #include "Parser.h"
+#include "TokenStream.h"
 
 #include <sstream>
 #include <functional>
@@ -7,41 +8,272 @@
 #include <fstream>
 #include <iostream>
 #include <iosfwd>
+#include <cstring>
+#include <thread>
 #include <Core/Log.h>
+#include <Core/Profiler.h>
 #include <Core/Utils.h>
+#include <Core/Scan.h>
 
 
 
 namespace clear
 {
-	Parser::Parser()
+	std::string_view ProgramInfo::GetData(const Token& token) const
 	{
-		m_StateMap[ParserState::Default]      = [this]() { _DefaultState(); };
-		m_StateMap[ParserState::VariableName] = [this]() { _VariableNameState(); };
-		m_StateMap[ParserState::RValue]       = [this]() { _ParsingRValueState(); };
-		m_StateMap[ParserState::Operator]     = [this]() { _OperatorState(); };
-		m_StateMap[ParserState::Indentation]  = [this]() { _IndentationState(); };
-		m_StateMap[ParserState::FunctionName] = [this]() {_FunctionNameState();};
-		m_StateMap[ParserState::FunctionParameters] = [this]() { _FunctionParameterState(); };
-		m_StateMap[ParserState::ArrowState] = [this](){_ArrowState();};
-		m_StateMap[ParserState::FunctionTypeState] = [this]() {_FunctionTypeState();};
-		m_StateMap[ParserState::StructName] = [this]() { _StructNameState(); };
-		m_StateMap[ParserState::FunctionParamaters] = [this]()  {_FunctionParamaterState(); };
-		m_StateMap[ParserState::Comment] = [this]() { _CommentState(); };
-		m_StateMap[ParserState::MultilineComment] = [this]() { _MultiLineCommentState(); };
-		m_StateMap[ParserState::IndexOperator] = [this]() { _IndexOperatorState(); };
-		m_StateMap[ParserState::AsterisksOperator] = [this]() {_AsterisksState();};
+		switch (token.Flags)
+		{
+			case TokenFlags::Source:  return std::string_view(Source->getBufferStart() + token.Offset, token.Length);
+			case TokenFlags::Payload: return GetPayloadText(token, std::string_view(Payloads).substr(token.Offset, token.Length));
+			case TokenFlags::None:
+			default:
+				break;
+		}
+
+		return {};
+	}
+
+	NumberLiteral ProgramInfo::GetLiteral(const Token& token) const
+	{
+		CLEAR_VERIFY(token.Flags == TokenFlags::Payload, "token is not a decoded number");
+		return GetPayloadLiteral(token, std::string_view(Payloads).substr(token.Offset, token.Length));
+	}
+
+	std::string_view GetPayloadText(const Token& token, std::string_view payload)
+	{
+		// a number's payload starts with the literal decoded from it
+		if (token.TokenType == TokenType::RValueNumber)
+			payload.remove_prefix(sizeof(NumberLiteral));
+
+		return payload;
+	}
+
+	NumberLiteral GetPayloadLiteral(const Token& token, std::string_view payload)
+	{
+		CLEAR_VERIFY(token.TokenType == TokenType::RValueNumber && payload.size() >= sizeof(NumberLiteral), "token is not a decoded number");
+
+		NumberLiteral literal;
+		std::memcpy(&literal, payload.data(), sizeof(NumberLiteral));
+
+		return literal;
+	}
+
+	void ProgramInfo::Serialize(BinaryWriter& writer) const
+	{
+		writer.WriteArray(Tokens);
+		writer.WriteString(Payloads);
+		writer.WriteArray(SyncPoints);
+	}
+
+	ProgramInfo ProgramInfo::Deserialize(BinaryReader& reader, std::shared_ptr<llvm::MemoryBuffer> source)
+	{
+		ProgramInfo info;
+		info.Source = std::move(source);
+
+		reader.ReadArray(info.Tokens);
+		info.Payloads = reader.ReadString();
+		reader.ReadArray(info.SyncPoints);
+
+		return info;
+	}
+
+	void Parser::_PushToken(const TokenType tok, std::string_view data, size_t start) 
+	{
+		Token token;
+		token.TokenType = tok;
+		token.Length = (uint32_t)data.size();
+
+		auto inSource = [this](std::string_view view)
+			{
+				return !m_Source.empty() && view.data() >= m_Source.data() && view.data() + view.size() <= m_Source.data() + m_Source.size();
+			};
+
+		const size_t end = std::min(m_CurrentTokenIndex, m_Buffer.length());
+
+		// data built up character by character was usually just read from the buffer, possibly
+		// followed by the character that ended it, so the token can point at the buffer instead
+		if (!data.empty() && !inSource(data))
+		{
+			for (size_t skipped = 0; skipped < 2; skipped++)
+			{
+				if (end < data.size() + skipped)
+					break;
+
+				std::string_view read = m_Buffer.substr(end - data.size() - skipped, data.size());
+
+				if (read == data && inSource(read))
+				{
+					data = read;
+					break;
+				}
+			}
+		}
+
+		// tokens without data are placed at the last character read, decoded literals at the character they began at
+		const size_t read = start != std::string_view::npos ? std::min(start, end) : (end > 0 ? end - 1 : 0);
+		size_t location = inSource(m_Buffer) ? size_t(m_Buffer.data() - m_Source.data()) + read : m_CursorOffset;
+
+		if (data.empty())
+		{
+			token.Flags = TokenFlags::None;
+		}
+		else if (inSource(data))
+		{
+			token.Flags = TokenFlags::Source;
+			token.Offset = (uint32_t)(data.data() - m_Source.data());
+			location = token.Offset;
+		}
+		else
+		{
+			token.Flags = TokenFlags::Payload;
+			token.Offset = (uint32_t)m_ProgramInfo.Payloads.size();
+			m_ProgramInfo.Payloads += data;
+		}
+
+		_SetLocation(token, location);
+		m_ProgramInfo.Tokens.push_back(token);
+	}
+
+	void Parser::_PushNumber(std::string_view text, const NumberLiteral& literal, size_t start)
+	{
+		_PushToken(TokenType::RValueNumber, text, start);
+
+		// the decoded literal goes in front of the text, the token keeps the location of the text
+		Token& token = m_ProgramInfo.Tokens.back();
+		const char* header = (const char*)&literal;
+
+		if (token.Flags == TokenFlags::Payload)
+		{
+			m_ProgramInfo.Payloads.insert(token.Offset, header, sizeof(NumberLiteral));
+		}
+		else
+		{
+			token.Flags = TokenFlags::Payload;
+			token.Offset = (uint32_t)m_ProgramInfo.Payloads.size();
 
+			m_ProgramInfo.Payloads.append(header, sizeof(NumberLiteral));
+			m_ProgramInfo.Payloads += text;
+		}
+
+		token.Length = uint32_t(sizeof(NumberLiteral) + text.size());
 	}
 
-	void Parser::_PushToken(const TokenType tok, const std::string &data) 
+	void Parser::_SetLocation(Token& token, size_t offset)
 	{
-		m_ProgramInfo.Tokens.push_back({ .TokenType = tok, .Data = data });
+		offset = std::min(offset, m_Source.size());
+
+		while (m_CursorOffset < offset)
+		{
+			if (m_Source[m_CursorOffset++] == '\n')
+			{
+				m_CursorLine++;
+				m_CursorLineStart = m_CursorOffset;
+			}
+		}
+
+		// only happens when a nested region's tokens are behind the enclosing region's last token
+		if (m_CursorOffset > offset)
+		{
+			while (m_CursorOffset > offset)
+			{
+				if (m_Source[--m_CursorOffset] == '\n')
+					m_CursorLine--;
+			}
+
+			size_t lineEnd = offset == 0 ? std::string_view::npos : m_Source.rfind('\n', offset - 1);
+			m_CursorLineStart = lineEnd == std::string_view::npos ? 0 : lineEnd + 1;
+		}
+
+		token.Line = (uint32_t)m_CursorLine;
+		token.Column = (uint16_t)std::min<size_t>(offset - m_CursorLineStart + 1, UINT16_MAX);
+	}
+
+	// lexes a nested region (a call argument, an index or a type) as if it were a program of its own, the tokens go
+	// straight into m_ProgramInfo instead of through a sub parser
+	void Parser::_LexRegion(std::string_view buffer)
+	{
+		// text that was rebuilt rather than sliced has to outlive the region, m_CurrentString is reset by it
+		std::string text;
+
+		if (buffer.data() < m_Source.data() || buffer.data() + buffer.size() > m_Source.data() + m_Source.size())
+		{
+			text = buffer;
+			buffer = text;
+		}
+
+		_PushRegion(buffer);
+
+		while (m_CurrentTokenIndex < _GetBufferLength())
+		{
+			_RunState();
+		}
+
+		while (m_Indents > 0)
+		{
+			_PushToken(TokenType::EndIndentation);
+			m_Indents--;
+		}
+
+		_PopRegion();
+	}
+
+	void Parser::_PushRegion(std::string_view buffer)
+	{
+		LexerRegion& region = m_RegionStack.emplace_back();
+		region.Buffer = m_Buffer;
+		region.TokenIndex = m_CurrentTokenIndex;
+		region.TokenBase = m_TokenBase;
+		region.Sentinel = m_Sentinel;
+		region.State = m_CurrentState;
+		region.Indents = m_Indents;
+		region.IndentLevel = m_CurrentIndentLevel;
+		region.IndentationLevel = m_CurrentIndentationLevel;
+		region.LineStarted = m_LineStarted;
+		region.CurrentString = std::move(m_CurrentString);
+		region.BracketStack = std::move(m_BracketStack);
+
+		m_Buffer = buffer;
+		m_CurrentTokenIndex = 0;
+		m_TokenBase = m_ProgramInfo.Tokens.size();
+		m_Sentinel = ' ';
+		m_CurrentState = ParserState::Default;
+		m_Indents = 0;
+		m_CurrentIndentLevel = 0;
+		m_CurrentIndentationLevel = 0;
+		m_LineStarted = false;
+		m_CurrentString.clear();
+		m_BracketStack.clear();
+	}
+
+	void Parser::_PopRegion()
+	{
+		CLEAR_VERIFY(!m_RegionStack.empty(), "no lexer region to pop");
+
+		LexerRegion& region = m_RegionStack.back();
+		m_Buffer = region.Buffer;
+		m_CurrentTokenIndex = region.TokenIndex;
+		m_TokenBase = region.TokenBase;
+		m_Sentinel = region.Sentinel;
+		m_CurrentState = region.State;
+		m_Indents = region.Indents;
+		m_CurrentIndentLevel = region.IndentLevel;
+		m_CurrentIndentationLevel = region.IndentationLevel;
+		m_LineStarted = region.LineStarted;
+		m_CurrentString = std::move(region.CurrentString);
+		m_BracketStack = std::move(region.BracketStack);
+
+		m_RegionStack.pop_back();
+	}
+
+	std::string_view Parser::_SliceBuffer(size_t start, const std::string& text)
+	{
+		std::string_view slice = m_Buffer.substr(std::min(start, m_Buffer.length()), text.size());
+		return slice == text ? slice : std::string_view(text);
 	}
 
 	Token Parser::_GetLastToken() {
-		if (m_ProgramInfo.Tokens.empty())
-			return Token{.TokenType = TokenType::EndLine,.Data = ""};
+		if (m_ProgramInfo.Tokens.size() == m_TokenBase)
+			return Token{.TokenType = TokenType::EndLine};
 
 		return m_ProgramInfo.Tokens.at(m_ProgramInfo.Tokens.size()-1);
 	}
@@ -55,6 +287,13 @@ namespace clear
 			return c;
 		}
 
+		if (m_Buffer.length() == m_CurrentTokenIndex)
+		{
+			m_CurrentTokenIndex++;
+			m_ReadSentinel |= m_RegionStack.empty();
+			return m_Sentinel;
+		}
+
 		return 0;
 	}
 
@@ -70,75 +309,647 @@ namespace clear
 
 	void Parser::_EndLine() 
 	{
-		m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::EndLine });
+		_PushToken(TokenType::EndLine);
 	}
 
+	// tokens are handed to a stream in batches of this many, the lock it takes is paid once per batch
+	static constexpr size_t s_StreamBatchSize = 256;
+
 	ProgramInfo Parser::ParseProgram() 
 	{
-		while (m_CurrentTokenIndex < m_Buffer.length())
+		while (m_CurrentTokenIndex < _GetBufferLength())
 		{
-			m_StateMap.at(m_CurrentState)();
+			_RunState();
+
+			if (m_Incremental && _AtSyncPoint())
+				_RecordSyncPoint();
+
+			// the last tokens are still looked at (and the last may be popped) by the states that follow
+			if (m_Stream && m_ProgramInfo.Tokens.size() >= s_StreamBatchSize)
+				_FlushTokens(2);
 		}
 
 		while (m_Indents > 0)
 		{
-			m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::EndIndentation });
+			_PushToken(TokenType::EndIndentation);
 			m_Indents--;
 		}
 
-		return m_ProgramInfo;
+		if (m_Stream)
+			_FlushTokens(0);
+
+		return std::move(m_ProgramInfo);
+	}
+
+	// a switch compiles to a jump table, the old std::map<ParserState, std::function> cost a tree walk and an indirect call per character
+	void Parser::_RunState()
+	{
+		switch (m_CurrentState)
+		{
+			case ParserState::Default:            _DefaultState(); break;
+			case ParserState::VariableName:       _VariableNameState(); break;
+			case ParserState::RValue:             _ParsingRValueState(); break;
+			case ParserState::Operator:           _OperatorState(); break;
+			case ParserState::Indentation:        _IndentationState(); break;
+			case ParserState::FunctionName:       _FunctionNameState(); break;
+			case ParserState::FunctionParameters: _FunctionParameterState(); break;
+			case ParserState::ArrowState:         _ArrowState(); break;
+			case ParserState::FunctionTypeState:  _FunctionTypeState(); break;
+			case ParserState::StructName:         _StructNameState(); break;
+			case ParserState::FunctionParamaters: _FunctionParamaterState(); break;
+			case ParserState::Comment:            _CommentState(); break;
+			case ParserState::MultilineComment:   _MultiLineCommentState(); break;
+			case ParserState::IndexOperator:      _IndexOperatorState(); break;
+			case ParserState::AsterisksOperator:  _AsterisksState(); break;
+			default:
+				CLEAR_ANNOTATED_HALT("unhandled parser state");
+				break;
+		}
 	}
 
 	void Parser::InitParser() 
 	{
-		m_ProgramInfo.Tokens.clear();
+		m_ProgramInfo = {};
 		m_CurrentTokenIndex = 0;
 		m_Indents = 0;
 		m_CurrentIndentLevel = 0;
 		m_CurrentIndentationLevel = 0;
 		m_LineStarted = false;
 		m_CurrentState = ParserState::Default;
-		m_Buffer.clear();
+		m_Source = {};
+		m_Buffer = {};
+		m_Sentinel = '\n';
+		m_CursorOffset = 0;
+		m_CursorLine = 1;
+		m_CursorLineStart = 0;
+		m_RegionStack.clear();
+		m_TokenBase = 0;
+		m_IndentsUnknown = false;
+		m_FirstIndents = 0;
+		m_ReadSentinel = false;
+		m_Stream = nullptr;
 		m_CurrentString.clear();
+		m_BracketStack.clear();
 	}
 
 
-	ProgramInfo Parser::CreateTokensFromFile(const std::filesystem::path& path)
+	ProgramInfo Parser::CreateTokensFromFile(const std::filesystem::path& path, uint32_t threads)
 	{
+		CLEAR_PROFILE_SCOPE("Parser::CreateTokensFromFile");
+
 		InitParser();
-		m_File.open(path);
 
-		if (!m_File.is_open())
+		// large files are memory mapped, the lexer scans them in place
+		auto source = llvm::MemoryBuffer::getFile(path.string(), /*IsText=*/false, /*RequiresNullTerminator=*/false);
+
+		if (!source)
 		{
 			std::cout << "failed to open file " << path << std::endl;
 			return m_ProgramInfo;
 		}
 
-		std::stringstream stream;
-		stream << m_File.rdbuf();
+		return CreateTokensFromBuffer(std::move(*source), threads);
+	}
 
-		m_Buffer = stream.str();
-		m_Buffer+='\n';
+	ProgramInfo Parser::CreateTokensFromBuffer(std::shared_ptr<llvm::MemoryBuffer> source, uint32_t threads)
+	{
+		InitParser();
+
+		m_ProgramInfo.Source = std::move(source);
+		m_Source = m_ProgramInfo.Source->getBuffer();
+		m_Buffer = m_Source;
+
+		if (threads != 1 && !m_Incremental && _ParseProgramParallel(threads))
+			return std::move(m_ProgramInfo);
+
+		CLEAR_PROFILE_SCOPE("Parser::ParseProgram");
 		return ParseProgram();
 
 	}
 
+	void Parser::StreamTokensFromFile(const std::filesystem::path& path, TokenStream& stream)
+	{
+		CLEAR_PROFILE_SCOPE("Parser::StreamTokensFromFile");
+
+		InitParser();
+
+		auto source = llvm::MemoryBuffer::getFile(path.string(), /*IsText=*/false, /*RequiresNullTerminator=*/false);
+
+		if (!source)
+		{
+			std::cout << "failed to open file " << path << std::endl;
+			stream.Close();
+			return;
+		}
+
+		m_ProgramInfo.Source = std::move(*source);
+		m_Source = m_ProgramInfo.Source->getBuffer();
+		m_Buffer = m_Source;
+
+		stream.SetSource(m_ProgramInfo.Source);
+
+		m_Stream = &stream;
+		ParseProgram();
+		m_Stream = nullptr;
+
+		stream.Close();
+	}
+
+	// copies the payloads the tokens point at into a new arena, the ones no token points at anymore are dropped
+	static void CompactPayloads(std::vector<Token>& tokens, std::string& payloads)
+	{
+		std::string compacted;
+
+		for (Token& token : tokens)
+		{
+			if (token.Flags != TokenFlags::Payload)
+				continue;
+
+			const size_t offset = compacted.size();
+			compacted += std::string_view(payloads).substr(token.Offset, token.Length);
+			token.Offset = (uint32_t)offset;
+		}
+
+		payloads = std::move(compacted);
+	}
+
+	void Parser::_FlushTokens(size_t keep)
+	{
+		CLEAR_VERIFY(m_RegionStack.empty(), "tokens can only be streamed between top level states");
+
+		std::vector<Token>& tokens = m_ProgramInfo.Tokens;
+		const size_t count = tokens.size() - std::min(keep, tokens.size());
+
+		m_Stream->Push(tokens.data(), count, m_ProgramInfo.Payloads);
+		tokens.erase(tokens.begin(), tokens.begin() + count);
+
+		// only the payloads of the kept tokens are still needed
+		CompactPayloads(tokens, m_ProgramInfo.Payloads);
+	}
+
+	TokenEdit Parser::UpdateTokens(ProgramInfo& info, const TextEdit& edit)
+	{
+		CLEAR_PROFILE_SCOPE("Parser::UpdateTokens");
+
+		const std::string_view previous = info.Source->getBuffer();
+		CLEAR_VERIFY(edit.Start <= edit.End && edit.End <= previous.size(), "edit is outside of the source");
+
+		const size_t size = previous.size() - (edit.End - edit.Start) + edit.Text.size();
+		auto source = llvm::WritableMemoryBuffer::getNewUninitMemBuffer(size, info.Source->getBufferIdentifier());
+
+		char* data = source->getBufferStart();
+		std::memcpy(data, previous.data(), edit.Start);
+		std::memcpy(data + edit.Start, edit.Text.data(), edit.Text.size());
+		std::memcpy(data + edit.Start + edit.Text.size(), previous.data() + edit.End, previous.size() - edit.End);
+
+		const int64_t delta = int64_t(size) - int64_t(previous.size());
+		const size_t editEnd = edit.Start + edit.Text.size();
+
+		// the text before the last sync point at or before the edit is unchanged, and so is the lexer state there.
+		// there is none before the first line, lexing starts over from the beginning then
+		const std::vector<LexerSyncPoint>& syncPoints = info.SyncPoints;
+
+		auto restart = std::upper_bound(syncPoints.begin(), syncPoints.end(), edit.Start,
+			[](size_t offset, const LexerSyncPoint& point) { return offset < point.Offset; });
+
+		const size_t keptSyncPoints = size_t(restart - syncPoints.begin());
+		const LexerSyncPoint start = keptSyncPoints > 0 ? *(restart - 1) : LexerSyncPoint{};
+
+		InitParser();
+
+		m_Source = std::string_view(data, size);
+		m_Buffer = m_Source;
+
+		m_CurrentTokenIndex = start.Offset;
+		m_CursorOffset = start.Offset;
+		m_CursorLine = start.Line;
+		m_CursorLineStart = start.Offset;
+
+		if (keptSyncPoints > 0)
+		{
+			m_CurrentState = ParserState::Indentation;
+			m_Indents = start.Indents;
+		}
+
+		// the states look back at the last two tokens, so the ones before the restart are put back for them
+		const size_t seed = std::min<size_t>(start.Token, 2);
+		m_ProgramInfo.Tokens.assign(info.Tokens.begin() + (start.Token - seed), info.Tokens.begin() + start.Token);
+
+		// past the edit the text is the same as before, once the lexer is in the state it was in at the same
+		// text before the edit every token that follows is the same as well
+		const LexerSyncPoint* resync = nullptr;
+
+		while (m_CurrentTokenIndex < _GetBufferLength())
+		{
+			_RunState();
+
+			if (!_AtSyncPoint())
+				continue;
+
+			// tokens lexed at the end of the file are placed on its last line, they are always lexed again
+			if (m_CurrentTokenIndex >= editEnd && m_CurrentTokenIndex < size)
+			{
+				const size_t offset = size_t(int64_t(m_CurrentTokenIndex) - delta);
+
+				auto it = std::lower_bound(restart, syncPoints.end(), offset,
+					[](const LexerSyncPoint& point, size_t offset) { return point.Offset < offset; });
+
+				if (it != syncPoints.end() && it->Offset == offset && it->Indents == m_Indents)
+				{
+					resync = &*it;
+					break;
+				}
+			}
+
+			_RecordSyncPoint();
+		}
+
+		if (!resync)
+		{
+			while (m_Indents > 0)
+			{
+				_PushToken(TokenType::EndIndentation);
+				m_Indents--;
+			}
+		}
+
+		// the sync points were recorded with the put back tokens in front
+		for (LexerSyncPoint& point : m_ProgramInfo.SyncPoints)
+			point.Token = uint32_t(point.Token - seed + start.Token);
+
+		TokenEdit result;
+		result.First = start.Token;
+		result.OldEnd = resync ? resync->Token : info.Tokens.size();
+		result.NewEnd = result.First + m_ProgramInfo.Tokens.size() - seed;
+
+		int64_t lineDelta = 0;
+
+		if (resync)
+		{
+			Token location;
+			_SetLocation(location, m_CurrentTokenIndex);
+			lineDelta = int64_t(location.Line) - int64_t(resync->Line);
+		}
+
+		const int64_t tokenDelta = int64_t(result.NewEnd) - int64_t(result.OldEnd);
+
+		// the sync points of the tail move with it, the ones lexed again replace those in between
+		std::vector<LexerSyncPoint> tail;
+
+		if (resync)
+			tail.assign(syncPoints.begin() + (resync - syncPoints.data()), syncPoints.end());
+
+		info.SyncPoints.resize(keptSyncPoints);
+		info.SyncPoints.insert(info.SyncPoints.end(), m_ProgramInfo.SyncPoints.begin(), m_ProgramInfo.SyncPoints.end());
+
+		for (LexerSyncPoint& point : tail)
+		{
+			point.Offset = uint32_t(point.Offset + delta);
+			point.Line = uint32_t(point.Line + lineDelta);
+			point.Token = uint32_t(point.Token + tokenDelta);
+			info.SyncPoints.push_back(point);
+		}
+
+		// the relexed tokens take the place of the old ones, the tail is moved once and shifted in place
+		std::vector<Token>& tokens = info.Tokens;
+
+		if (tokenDelta > 0)
+			tokens.insert(tokens.begin() + result.OldEnd, size_t(tokenDelta), Token{});
+		else
+			tokens.erase(tokens.begin() + (result.OldEnd + tokenDelta), tokens.begin() + result.OldEnd);
+
+		const uint32_t payloadBase = (uint32_t)info.Payloads.size();
+
+		for (size_t i = seed; i < m_ProgramInfo.Tokens.size(); i++)
+		{
+			Token token = m_ProgramInfo.Tokens[i];
+
+			if (token.Flags == TokenFlags::Payload)
+				token.Offset += payloadBase;
+
+			tokens[result.First + i - seed] = token;
+		}
+
+		for (size_t i = result.NewEnd; i < tokens.size(); i++)
+		{
+			Token& token = tokens[i];
+			token.Line = uint32_t(token.Line + lineDelta);
+
+			if (token.Flags == TokenFlags::Source)
+				token.Offset = uint32_t(token.Offset + delta);
+		}
+
+		info.Payloads += m_ProgramInfo.Payloads;
+		info.Source = std::move(source);
+
+		// payloads of the replaced tokens are left behind, the arena is rebuilt once they are more than half of it
+		size_t livePayloads = 0;
+
+		for (const Token& token : tokens)
+		{
+			if (token.Flags == TokenFlags::Payload)
+				livePayloads += token.Length;
+		}
+
+		if (info.Payloads.size() > 2 * livePayloads)
+			CompactPayloads(tokens, info.Payloads);
+
+		return result;
+	}
+
+	bool Parser::_AtSyncPoint() const
+	{
+		return m_CurrentState == ParserState::Indentation && m_RegionStack.empty() && m_BracketStack.empty() && m_CurrentString.empty() &&
+			   m_CurrentTokenIndex > 0 && m_CurrentTokenIndex <= m_Buffer.length() && m_Buffer[m_CurrentTokenIndex - 1] == '\n';
+	}
+
+	void Parser::_RecordSyncPoint()
+	{
+		std::vector<LexerSyncPoint>& syncPoints = m_ProgramInfo.SyncPoints;
+
+		if (!syncPoints.empty() && syncPoints.back().Offset >= m_CurrentTokenIndex)
+			return;
+
+		Token location;
+		_SetLocation(location, m_CurrentTokenIndex);
+
+		syncPoints.push_back({ .Offset = (uint32_t)m_CurrentTokenIndex, .Line = location.Line, .Token = (uint32_t)m_ProgramInfo.Tokens.size(), .Indents = (uint32_t)m_Indents });
+	}
+
+	// chunks smaller than this aren't worth a thread
+	static constexpr size_t s_MinChunkSize = 256 * 1024;
+
+	bool Parser::_ParseProgramParallel(uint32_t threads)
+	{
+		CLEAR_PROFILE_SCOPE("Parser::ParseProgramParallel");
+
+		const uint32_t threadCount = threads ? threads : std::max(std::thread::hardware_concurrency(), 1u);
+		const size_t chunkCount = std::min<size_t>(threadCount, m_Source.size() / s_MinChunkSize);
+
+		if (chunkCount < 2)
+			return false;
+
+		std::vector<LexerChunk> chunks = _SplitSource(chunkCount);
+
+		if (chunks.size() < 2)
+			return false;
+
+		ParallelFor(chunks.size(), threadCount, [&](size_t i)
+			{
+				CLEAR_PROFILE_SCOPE("Parser::LexChunk");
+
+				Parser parser;
+				parser._LexChunk(m_Source, chunks[i], i == 0, i + 1 == chunks.size());
+			});
+
+		for (const LexerChunk& chunk : chunks)
+		{
+			if (!chunk.Valid)
+				return false;
+		}
+
+		CLEAR_PROFILE_SCOPE("Parser::StitchChunks");
+
+		size_t tokenCount = 0;
+		size_t payloadSize = 0;
+
+		for (const LexerChunk& chunk : chunks)
+		{
+			tokenCount += chunk.Info.Tokens.size();
+			payloadSize += chunk.Info.Payloads.size();
+		}
+
+		std::vector<Token>& tokens = m_ProgramInfo.Tokens;
+		tokens.reserve(tokenCount);
+		m_ProgramInfo.Payloads.reserve(payloadSize);
+
+		size_t indents = 0;
+
+		for (size_t i = 0; i < chunks.size(); i++)
+		{
+			const LexerChunk& chunk = chunks[i];
+			const uint32_t payloadBase = (uint32_t)m_ProgramInfo.Payloads.size();
+
+			size_t first = 0;
+
+			// replace the placeholder with what _IndentationState would have pushed knowing the previous chunk's indentation
+			if (i > 0)
+			{
+				CLEAR_VERIFY(!chunk.Info.Tokens.empty(), "chunk is missing its indentation placeholder");
+
+				Token indentation = chunk.Info.Tokens.front();
+				first = 1;
+
+				if (chunk.FirstIndents > indents)
+				{
+					indentation.TokenType = TokenType::StartIndentation;
+					tokens.push_back(indentation);
+				}
+
+				indentation.TokenType = TokenType::EndIndentation;
+
+				for (size_t j = chunk.FirstIndents; j < indents; j++)
+					tokens.push_back(indentation);
+			}
+
+			for (size_t j = first; j < chunk.Info.Tokens.size(); j++)
+			{
+				Token token = chunk.Info.Tokens[j];
+
+				if (token.Flags == TokenFlags::Payload)
+					token.Offset += payloadBase;
+
+				tokens.push_back(token);
+			}
+
+			m_ProgramInfo.Payloads += chunk.Info.Payloads;
+			indents = chunk.FinalIndents;
+		}
+
+		return true;
+	}
+
+	// walks the source roughly the way the lexer does, only tracking brackets, strings and comments, and cuts it
+	// at line breaks that start a new top level line. a chunk the lexer doesn't end where expected is caught after
+	// lexing and the file is lexed serially instead
+	std::vector<LexerChunk> Parser::_SplitSource(size_t chunkCount)
+	{
+		const std::string_view source = m_Source;
+		const size_t target = source.size() / chunkCount;
+
+		std::vector<LexerChunk> chunks;
+
+		size_t chunkStart = 0;
+		size_t chunkLine = 1;
+		size_t line = 1;
+		size_t depth = 0;
+
+		auto countLines = [&](size_t from, size_t to)
+			{
+				line += std::count(source.begin() + from, source.begin() + std::min(to, source.size()), '\n');
+			};
+
+		auto pushChunk = [&](size_t end)
+			{
+				LexerChunk& chunk = chunks.emplace_back();
+				chunk.Start = chunkStart;
+				chunk.End = end;
+				chunk.Line = chunkLine;
+			};
+
+		for (size_t i = 0; i < source.size(); i++)
+		{
+			switch (source[i])
+			{
+				case '\n':
+				{
+					line++;
+
+					const bool split = depth == 0 && i > 0 && source[i - 1] != '\n' && i + 1 < source.size() && IsVarNameChar(source[i + 1]);
+
+					if (split && i + 1 - chunkStart >= target && chunks.size() + 1 < chunkCount)
+					{
+						pushChunk(i + 1);
+						chunkStart = i + 1;
+						chunkLine = line;
+					}
+
+					break;
+				}
+				case '"':
+				{
+					// strings end at a line break at the latest
+					size_t end = FindStringEnd(source, i + 1);
+
+					while (end < source.size() && source[end] == '\\')
+						end = FindStringEnd(source, end + 2);
+
+					i = end < source.size() && source[end] == '"' ? end : end - 1;
+					break;
+				}
+				case '\'':
+					i += i + 1 < source.size() && source[i + 1] == '\\' ? 3 : 2;
+					break;
+				case '/':
+				{
+					if (i + 1 >= source.size())
+						break;
+
+					if (source[i + 1] == '/')
+					{
+						i = FindLineEnd(source, i) - 1;
+					}
+					else if (source[i + 1] == '*')
+					{
+						// the character after /* is skipped by the lexer, and the comment closes with *\ instead of */
+
+						size_t end = i + 3;
+
+						while (true)
+						{
+							end = FindCommentEnd(source, end);
+
+							if (end + 1 >= source.size() || (source[end] == '*' && source[end + 1] == '\\'))
+								break;
+
+							end++;
+						}
+
+						countLines(i, end);
+						i = end + 1;
+					}
+
+					break;
+				}
+				case '(':
+				case '[':
+					depth++;
+					break;
+				case ')':
+				case ']':
+					depth -= depth > 0;
+					break;
+				default:
+					break;
+			}
+		}
+
+		pushChunk(source.size());
+		return chunks;
+	}
+
+	void Parser::_LexChunk(std::string_view source, LexerChunk& chunk, bool first, bool last)
+	{
+		InitParser();
+
+		m_Source = source;
+		m_Buffer = source.substr(chunk.Start, chunk.End - chunk.Start);
+
+		m_CursorOffset = chunk.Start;
+		m_CursorLine = chunk.Line;
+		m_CursorLineStart = chunk.Start;
+
+		// every chunk but the first starts right after the serial lexer would have read a line break
+		if (!first)
+		{
+			m_CurrentState = ParserState::Indentation;
+			m_IndentsUnknown = true;
+		}
+
+		if (last)
+		{
+			chunk.Info = ParseProgram();
+			chunk.Valid = true;
+		}
+		else
+		{
+			while (m_CurrentTokenIndex < m_Buffer.length())
+			{
+				_RunState();
+			}
+
+			chunk.Valid = !m_ReadSentinel && m_CurrentTokenIndex == m_Buffer.length() && _AtSyncPoint();
+
+			chunk.FinalIndents = m_Indents;
+			chunk.Info = std::move(m_ProgramInfo);
+		}
+
+		chunk.FirstIndents = m_FirstIndents;
+	}
+
 	 char Parser::_SkipSpaces() {
 		_Backtrack();
-		char current = _GetNextChar();
-		while (IsSpace(current))
+		char current;
+
+		// a nested region's sentinel is a space, so skipping can continue past the end once
+		do {
+			m_CurrentTokenIndex = SkipSpaces(m_Buffer, m_CurrentTokenIndex);
 			current = _GetNextChar();
+		} while (IsSpace(current));
 
 		return current;
 	 }
 
+	void Parser::_ReadVarName(char& current)
+	{
+		if (!IsVarNameChar(current))
+			return;
+
+		const size_t start = m_CurrentTokenIndex - 1;
+		m_CurrentTokenIndex = SkipVarName(m_Buffer, m_CurrentTokenIndex);
+		m_CurrentString += m_Buffer.substr(start, m_CurrentTokenIndex - start);
+
+		current = _GetNextChar();
+	}
+
 	void Parser::_FunctionParamaterState() {
 		char current = _GetNextChar();
 
 		current = _SkipSpaces();
 		m_CurrentString.clear();
 		CLEAR_VERIFY(current == '(', "expected ( after function call");
-		std::vector<std::string> argList;
+		std::vector<std::pair<size_t, std::string>> argList; // where each argument starts in the buffer and its text
+		size_t argStart = 0;
 		bool detectedEnd = false;
 		int opens =1;
 		while (opens !=0 && current != '\0')
@@ -155,7 +966,7 @@ namespace clear
 					detectedEnd = true;
 
 				if (!m_CurrentString.empty())
-					argList.push_back(m_CurrentString);
+					argList.push_back({ argStart, m_CurrentString });
 				else {
 					if (current == ',') {
 					CLEAR_LOG_ERROR("Expected function Paramater after commas");
@@ -168,25 +979,21 @@ namespace clear
 			}
 			else
 			{
-				if(!(std::isspace(current) && m_CurrentString.empty()))
+				if (m_CurrentString.empty())
+					argStart = m_CurrentTokenIndex - 1;
+
+				if(!(IsWhitespace(current) && m_CurrentString.empty()))
 					m_CurrentString += current;
 			}
 
 		}
 
 		CLEAR_VERIFY(detectedEnd, "Expected ) after function call");
-		// m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::StartFunctionParameters, .Data = "" });
+		// _PushToken(TokenType::StartFunctionParameters);
 		m_CurrentState = ParserState::Default;
-		for (const std::string& arg : argList) {
-			Parser subParser;
-			subParser.InitParser();
-			subParser.m_Buffer = arg;
-			subParser.m_Buffer+=" ";
-			ProgramInfo info = subParser.ParseProgram();
-			for (const Token& tok :info.Tokens) {
-				m_ProgramInfo.Tokens.push_back(tok);
-			}
-			_PushToken(TokenType::Comma, "");
+		for (const auto& [start, arg] : argList) {
+			_LexRegion(_SliceBuffer(start, arg));
+			_PushToken(TokenType::Comma);
 		}
 		if (_GetLastToken().TokenType == TokenType::Comma) {
 			m_ProgramInfo.Tokens.pop_back();
@@ -202,6 +1009,7 @@ namespace clear
 	void Parser::_MultiLineCommentState() {
 		char current = _GetNextChar();
 		while (current!= '\0') {
+			m_CurrentTokenIndex = FindCommentEnd(m_Buffer, m_CurrentTokenIndex);
 			current = _GetNextChar();
 			if (current == '*') {
 				current = _GetNextChar();
@@ -218,6 +1026,7 @@ namespace clear
 	void Parser::_CommentState() {
 		char current = _GetNextChar();
 		while (current != '\n' && current != '\0') {
+			m_CurrentTokenIndex = FindLineEnd(m_Buffer, m_CurrentTokenIndex);
 			current = _GetNextChar();
 		}
 		m_CurrentState = ParserState::Default;
@@ -227,7 +1036,7 @@ namespace clear
 
 	bool Parser::_IsLineClosed() {
 
-		if (m_ProgramInfo.Tokens.empty())
+		if (m_ProgramInfo.Tokens.size() == m_TokenBase)
 			return true;
 		TokenType tok = _GetLastToken().TokenType;
 		return !(tok == TokenType::CloseBracket);
@@ -238,6 +1047,7 @@ namespace clear
 		char current = _GetNextChar();
 		bool detectedEnd = false;
 		int opens =1;
+		size_t indexStart = m_CurrentTokenIndex;
 
 		CLEAR_VERIFY(current == '[', "index op should start with [");
 		while (opens !=0 && current != '\0')
@@ -254,19 +1064,17 @@ namespace clear
 			}
 
 			if((!(IsSpace(current) && m_CurrentString.empty()) && current!= '\n'))
+			{
+				if (m_CurrentString.empty())
+					indexStart = m_CurrentTokenIndex - 1;
+
 				m_CurrentString += current;
+			}
 
 
 		}
 		CLEAR_VERIFY(detectedEnd, "Expected ] after index call");
-		Parser subParser;
-		subParser.InitParser();
-		subParser.m_Buffer = m_CurrentString;
-		subParser.m_Buffer+=" ";
-		ProgramInfo info = subParser.ParseProgram();
-		for (const Token& tok :info.Tokens) {
-			m_ProgramInfo.Tokens.push_back(tok);
-		}
+		_LexRegion(_SliceBuffer(indexStart, m_CurrentString));
 
 		m_CurrentString.clear();
 		m_CurrentState = ParserState::Default;
@@ -282,11 +1090,13 @@ namespace clear
 
 		if (current == '(')
 		{
+			const std::string_view bracket = m_Buffer.substr(m_CurrentTokenIndex - 1, 1);
+
 			if (!m_CurrentString.empty() || !_IsLineClosed()) 
 			{
 				if (!m_CurrentString.empty()) 
 				{
-					CLEAR_VERIFY(!IsValidNumber(m_CurrentString),"Cannot call a number")
+					CLEAR_VERIFY(!DecodeNumberLiteral(m_CurrentString).Valid,"Cannot call a number")
 					_PushToken(TokenType::VariableReference, m_CurrentString);
 				}
 
@@ -298,7 +1108,7 @@ namespace clear
 				m_BracketStack.push_back('(');
 			}
 
-			m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::OpenBracket, .Data = "(" });
+			_PushToken(TokenType::OpenBracket, bracket);
 
 
 			return;
@@ -312,7 +1122,7 @@ namespace clear
 			_ParseChar();
 		}
 
-		if (std::isdigit(current) && m_CurrentString.empty())
+		if (IsDigit(current) && m_CurrentString.empty())
 		{
 				m_CurrentString += current;
 				_ParseNumber();
@@ -320,19 +1130,22 @@ namespace clear
 		}
 
 		if (IsVarNameChar(current))
-			m_CurrentString += current;
-
+		{
+			// the rest of the identifier is read at once, the character after it is handled by the next call
+			const size_t start = m_CurrentTokenIndex - 1;
+			m_CurrentTokenIndex = SkipVarName(m_Buffer, m_CurrentTokenIndex);
+			m_CurrentString += m_Buffer.substr(start, m_CurrentTokenIndex - start);
+			return;
+		}
 
 		if (!m_CurrentString.empty() && !IsVarNameChar(current))
 		{
-			if ((!g_OperatorMap.contains(Str(current)) && current != '\n' && current != ')') || (g_DataTypes.contains(m_CurrentString) &&( current == '*' || current == '&'))) {
-				if (g_KeyWordMap.contains(m_CurrentString) ) {
-					auto& value = g_KeyWordMap.at(m_CurrentString);
-
-					m_CurrentState = value.NextState;
+			if ((!IsOperatorChar(current) && current != '\n' && current != ')') || (g_DataTypes.Contains(m_CurrentString) &&( current == '*' || current == '&'))) {
+				if (const ParserMapValue* value = g_KeyWordMap.Find(m_CurrentString)) {
+					m_CurrentState = value->NextState;
 
-					if (value.TokenToPush != TokenType::None)
-						m_ProgramInfo.Tokens.push_back({ .TokenType = value.TokenToPush, .Data = m_CurrentString });
+					if (value->TokenToPush != TokenType::None)
+						_PushToken(value->TokenToPush, m_CurrentString);
 
 					m_CurrentString.clear();
 
@@ -360,13 +1173,13 @@ namespace clear
 			m_CurrentState = ParserState::Indentation;
 			m_CurrentString.clear();
 			if (current == '\n' && m_BracketStack.empty())
-				_PushToken(TokenType::EndLine, "");
+				_PushToken(TokenType::EndLine);
 
 
 			return;
 		}
 
-		if (g_OperatorMap.contains(Str(current)))
+		if (IsOperatorChar(current))
 		{
 			m_CurrentState = ParserState::Operator;
 			m_CurrentString.clear();
@@ -374,7 +1187,7 @@ namespace clear
 
 		if (current == '[') {
 			m_CurrentState = ParserState::IndexOperator;
-			_PushToken(TokenType::IndexOperator,"");
+			_PushToken(TokenType::IndexOperator);
 			_PushToken(TokenType::OpenBracket,"[");
 			_Backtrack();
 
@@ -384,14 +1197,14 @@ namespace clear
 			CLEAR_VERIFY(!m_BracketStack.empty() && m_BracketStack.back() == '(', "Closing brackets unmatched");
 
 			m_BracketStack.pop_back();
-			m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::CloseBracket, .Data = ")"});
+			_PushToken(TokenType::CloseBracket, ")");
 
 			return;
 		}
 	}
 	void Parser::_ArrowState() 
 	{
-		if (m_ProgramInfo.Tokens.size() > 1 && 
+		if (m_ProgramInfo.Tokens.size() > m_TokenBase + 1 && 
 			m_ProgramInfo.Tokens.at(m_ProgramInfo.Tokens.size()-2).TokenType == TokenType::EndFunctionParameters)
 		{
 			m_CurrentState = ParserState::FunctionTypeState;
@@ -409,21 +1222,16 @@ namespace clear
 		current = _SkipSpaces();
 		m_CurrentString.clear();
 
+		const size_t typeStart = m_CurrentTokenIndex - 1;
+
 		//allow _ and any character from alphabet
 		while (current != '\n' && current != '\0' && current != ':')
 		{
 			m_CurrentString += current;
 			current = _GetNextChar();
 		}
-		m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::FunctionType, .Data =m_CurrentString });
-		Parser subParser;
-		subParser.InitParser();
-		subParser.m_Buffer = m_CurrentString;
-		subParser.m_Buffer+=" ";
-		ProgramInfo info = subParser.ParseProgram();
-		for (const Token& tok :info.Tokens) {
-			m_ProgramInfo.Tokens.push_back(tok);
-		}
+		_PushToken(TokenType::FunctionType, m_CurrentString);
+		_LexRegion(_SliceBuffer(typeStart, m_CurrentString));
 
 		_Backtrack();
 		m_CurrentString.clear();
@@ -440,11 +1248,7 @@ namespace clear
 			CLEAR_HALT();
 		}
 		m_CurrentString.clear();
-		while (IsVarNameChar(current))
-		{
-			m_CurrentString += current;
-			current = _GetNextChar();
-		}
+		_ReadVarName(current);
 
 
 		_PushToken(TokenType::StructName, m_CurrentString);
@@ -463,20 +1267,20 @@ namespace clear
 		m_CurrentString.clear();
 
 		//brackets
-		if (g_OperatorMap.contains(Str(current))) {
+		if (IsOperatorChar(current)) {
 			m_CurrentState = ParserState::Operator;
 			return;
 		}
 		if (current == '(')
 		{
 			m_BracketStack.push_back('(');
-			m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::OpenBracket, .Data = "(" });
+			_PushToken(TokenType::OpenBracket, "(");
 			m_CurrentState = ParserState::RValue;
 			return;
 		}
 		if (current == ')')
 		{
-			m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::CloseBracket, .Data = ")" });
+			_PushToken(TokenType::CloseBracket, ")");
 			m_CurrentState = ParserState::RValue;
 			
 			CLEAR_VERIFY(!m_BracketStack.empty() && m_BracketStack.back() == '(', "closing brackets unmatched");
@@ -488,7 +1292,7 @@ namespace clear
 		{
 			_ParseString();
 		}
-		else if (std::isdigit(current) || current == '-') // postive/negative numbers
+		else if (IsDigit(current) || current == '-') // postive/negative numbers
 		{
 			m_CurrentString.push_back(current);
 			_ParseNumber();
@@ -510,7 +1314,7 @@ namespace clear
 		char current = _GetNextChar();
 		while (current != ']' && current != '\n' && current != '\0')
 		{
-			if (std::isdigit(current)) {
+			if (IsDigit(current)) {
 				m_CurrentString += current;
 			}
 			else if ('.' == current && m_CurrentString.empty()) {
@@ -528,7 +1332,7 @@ namespace clear
 			current = _GetNextChar();
 		}
 		if (m_CurrentString.empty()) {
-			_PushToken(TokenType::DynamicArrayDef,"");
+			_PushToken(TokenType::DynamicArrayDef);
 		}else {
 			_PushToken(TokenType::StaticArrayDef,m_CurrentString);
 		}
@@ -568,7 +1372,7 @@ namespace clear
 
 		//want to ignore all spaces in between type and variable
 		current = _SkipSpaces();
-		if ((current == ':' || g_OperatorMap.contains(Str(current))) && current != '*') {
+		if ((current == ':' || IsOperatorChar(current)) && current != '*') {
 			_Backtrack();
 			m_CurrentState = ParserState::Default;
 			return;
@@ -601,16 +1405,20 @@ namespace clear
 
 		int commas = 0;
 		int vars = 0;
+		size_t nameStart = 0;
 		while ((current != '\0' || current != '\n') && (IsVarNameChar(current) || IsSpace(current)) ) {
 			if (!IsSpace(current)) {
+				if (m_CurrentString.empty())
+					nameStart = m_CurrentTokenIndex - 1;
+
 				m_CurrentString += current;
 			}
 			current = _GetNextChar();
 
 			if (current == ',') {
 				CLEAR_VERIFY(!m_CurrentString.empty(),"Expected variable name after comma")
-				_PushToken(TokenType::VariableName, m_CurrentString);
-				_PushToken(TokenType::Comma,"");
+				_PushToken(TokenType::VariableName, _SliceBuffer(nameStart, m_CurrentString));
+				_PushToken(TokenType::Comma);
 				m_CurrentString.clear();
 				current = _GetNextChar();
 				commas++;
@@ -622,7 +1430,7 @@ namespace clear
 			CLEAR_VERIFY(current != ',',"Expected variable name after comma")
 		}
 		if (!m_CurrentString.empty()) {
-			_PushToken(TokenType::VariableName, m_CurrentString);
+			_PushToken(TokenType::VariableName, _SliceBuffer(nameStart, m_CurrentString));
 			vars++;
 
 		}
@@ -643,7 +1451,8 @@ namespace clear
 		m_CurrentString.clear();
 		CLEAR_VERIFY(current == '(', "expected ( after function decleartion");
 
-		std::vector<std::string> argList;
+		std::vector<std::pair<size_t, std::string>> argList; // where each parameter starts in the buffer and its text
+		size_t argStart = 0;
 		bool detectedEnd = false;
 
 		while (current != ')' && current != '\0') 
@@ -656,13 +1465,16 @@ namespace clear
 					detectedEnd = true;
 
 				if (!m_CurrentString.empty())
-					argList.push_back(m_CurrentString);
+					argList.push_back({ argStart, m_CurrentString });
 
 				m_CurrentString.clear();
 
 			}
 			else 
 			{
+				if (m_CurrentString.empty())
+					argStart = m_CurrentTokenIndex - 1;
+
 				if(!(IsSpace(current) && m_CurrentString.empty()))
 					m_CurrentString += current;
 			}
@@ -670,21 +1482,13 @@ namespace clear
 		}
 
 		CLEAR_VERIFY(detectedEnd, "Expected ) after function decleartion");
-		m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::StartFunctionParameters, .Data = "" });
+		_PushToken(TokenType::StartFunctionParameters);
 
-		for (const auto& i: argList) 
+		for (const auto& [start, arg] : argList) 
 		{
-			Parser subParser;
-			subParser.InitParser();
-			subParser.m_Buffer = i;
-			subParser.m_Buffer+=" ";
-			ProgramInfo info = subParser.ParseProgram();
-			for (const Token& tok :info.Tokens) {
-				m_ProgramInfo.Tokens.push_back(tok);
-			}
-
+			_LexRegion(_SliceBuffer(start, arg));
 		}
-		m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::EndFunctionParameters, .Data = "" });
+		_PushToken(TokenType::EndFunctionParameters);
 		m_CurrentState = ParserState::Default;
 		if (current != ')')
 			_Backtrack();
@@ -701,20 +1505,16 @@ namespace clear
 		{
 			_Backtrack();
 			m_CurrentState = ParserState::FunctionParameters;
-			m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::Lambda, .Data = ""});
+			_PushToken(TokenType::Lambda);
 			return;
 		}
 
-		while (IsVarNameChar(current))
-		{
-			m_CurrentString += current;
-			current = _GetNextChar();
-		}
+		_ReadVarName(current);
 
 		if (current =='(')
 			_Backtrack();
 
-		m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::FunctionName, .Data = m_CurrentString });
+		_PushToken(TokenType::FunctionName, m_CurrentString);
 		m_CurrentString.clear();
 
 		CLEAR_VERIFY(current != '\n', "did not expect new line after function def")
@@ -724,41 +1524,38 @@ namespace clear
 
 	void Parser::_OperatorState()
 	{
+		// the operator characters are contiguous in the buffer, so they are viewed rather than copied
 		_Backtrack();
-		std::string before = Str(_GetNextChar());
-		std::string h = before;
-		char current  = before[0];
-		while (g_OperatorMap.contains(Str(current)))
+		const size_t start = m_CurrentTokenIndex;
+		char current = _GetNextChar();
+		while (IsOperatorChar(current))
 		{
 			current = _GetNextChar();
 
-			if (!g_OperatorMap.contains(Str(current)))
+			if (!IsOperatorChar(current))
 				break;
-
-			h+=current;
 		}
 
-		ParserMapValue value;
-		std::string data;
 		_Backtrack();
 
-		if (g_OperatorMap.contains(h))
-		{
-			value = g_OperatorMap.at(h);
-			data = h;
-		}
-		else
-		{
+		const std::string_view h = m_Buffer.substr(start, m_CurrentTokenIndex - start);
+		std::string_view data = h;
+		const ParserMapValue* value = g_OperatorMap.Find(h);
 
-			value = g_OperatorMap.at(before);
-			data = before;
+		if (!value)
+		{
+			data = h.substr(0, 1);
+			value = g_OperatorMap.Find(data);
 			m_CurrentTokenIndex -= (h.size()-1);
 
 		}
-		if (value.TokenToPush != TokenType::None)
-			m_ProgramInfo.Tokens.push_back({ .TokenType = value.TokenToPush, .Data = data });
 
-		m_CurrentState = value.NextState;
+		CLEAR_VERIFY(value, "unknown operator ", data);
+
+		if (value->TokenToPush != TokenType::None)
+			_PushToken(value->TokenToPush, data);
+
+		m_CurrentState = value->NextState;
 	}
 
 	void Parser::_AsterisksState() {
@@ -767,7 +1564,7 @@ namespace clear
 		if (tok == TokenType::VariableReference || tok == TokenType::RValueChar || tok == TokenType::RValueNumber || tok == TokenType::RValueString) {
 			_PushToken(TokenType::MulOp,"*");
 		}else {
-			_PushToken(TokenType::DereferenceOp,"");
+			_PushToken(TokenType::DereferenceOp);
 		}
 		m_CurrentState = ParserState::Default;
 
@@ -811,15 +1608,23 @@ namespace clear
 				indenting = false;
 		}
 
+		if (m_IndentsUnknown)
+		{
+			_PushToken(TokenType::StartIndentation); // replaced when the chunks are stitched together
+			m_FirstIndents = localIndents;
+			m_Indents = localIndents;
+			m_IndentsUnknown = false;
+		}
+
 		if (localIndents > m_Indents)
 		{
-			m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::StartIndentation });
+			_PushToken(TokenType::StartIndentation);
 			m_Indents = localIndents;
 		}
 
 		while (m_Indents > localIndents)
 		{
-			m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::EndIndentation });
+			_PushToken(TokenType::EndIndentation);
 			m_Indents--;
 		}
 
@@ -827,11 +1632,11 @@ namespace clear
 		_Backtrack();
 	}
 
-	void Parser::_ParseHexLiteral() {
+	void Parser::_ParseHexLiteral(size_t start) {
 		m_CurrentString.clear();
 		char current = _GetNextChar();
-		while (!std::isspace(current) && !g_OperatorMap.contains(Str(current))) {
-			CLEAR_VERIFY(current == '0' || current == '1' || current == '2' || current == '3' || current == '4' || current == '5' || current == '6' || current == '7' || current == '8' || current == '9' || current == 'A' || current == 'B' || current == 'C' || current == 'D' || current == 'E' || current == 'F'  || current == 'a' || current == 'b' || current == 'c' || current == 'd' || current == 'e' || current == 'f',"Expected   hexadecimal characters only in hexadecimal literal");
+		while (!IsWhitespace(current) && !IsOperatorChar(current)) {
+			CLEAR_VERIFY(IsHexDigit(current),"Expected   hexadecimal characters only in hexadecimal literal");
 			m_CurrentString += current;
 			current = _GetNextChar();
 		}
@@ -840,14 +1645,17 @@ namespace clear
 			_Backtrack();
 		}
 
-		_PushToken(TokenType::RValueNumber,std::to_string(HexStringToInteger(m_CurrentString)));
+		const NumberLiteral literal = DecodeNumberLiteral(m_CurrentString, 16);
+		CLEAR_VERIFY(literal.Valid, "hexadecimal literal does not fit in 64 bits");
+
+		_PushNumber(std::to_string(literal.Value), literal, start);
 		m_CurrentString.clear();
 	}
-	void Parser::_ParseBinaryLiteral() {
+	void Parser::_ParseBinaryLiteral(size_t start) {
 		m_CurrentString.clear();
 		char current = _GetNextChar();
-		while (!std::isspace(current) && !g_OperatorMap.contains(Str(current))) {
-			CLEAR_VERIFY(current == '0' || current == '1',"Expected 1 and 0 only in binary literal");
+		while (!IsWhitespace(current) && !IsOperatorChar(current)) {
+			CLEAR_VERIFY(IsHexDigit(current),"Expected 1 and 0 only in binary literal");
 			m_CurrentString += current;
 			current = _GetNextChar();
 		}
@@ -856,7 +1664,10 @@ namespace clear
 			_Backtrack();
 		}
 
-		_PushToken(TokenType::RValueNumber,std::to_string(BinaryStringToInteger(m_CurrentString)));
+		const NumberLiteral literal = DecodeNumberLiteral(m_CurrentString, 2);
+		CLEAR_VERIFY(literal.Valid, "Expected 1 and 0 only in binary literal, at most 64 of them");
+
+		_PushNumber(std::to_string(literal.Value), literal, start);
 		m_CurrentString.clear();
 
 	}
@@ -864,11 +1675,13 @@ namespace clear
 
 	void Parser::_ParseNumber()
 	{
+		// the first character was read before getting here
+		const size_t start = m_CurrentTokenIndex - m_CurrentString.size();
 		char current = _GetNextChar();
 
 		if (current == '\0')
 		{
-			m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::RValueNumber, .Data = m_CurrentString });
+			_PushNumber(m_CurrentString, DecodeNumberLiteral(m_CurrentString), start);
 			m_CurrentString.clear();
 			return;
 		}
@@ -876,17 +1689,17 @@ namespace clear
 		bool usedDecimal = false;
 		if (current == 'b') {
 			CLEAR_VERIFY(m_CurrentString == "0", "expected binary literal to start with 0");
-			_ParseBinaryLiteral();
+			_ParseBinaryLiteral(start);
 			return;
 		}
 
 		if (current == 'x') {
 			CLEAR_VERIFY(m_CurrentString == "0", "expected hex literal to start with 0");
-			_ParseHexLiteral();
+			_ParseHexLiteral(start);
 			return;
 		}
 
-		while (std::isalnum(current))
+		while (IsAlphaNumeric(current))
 		{
 			m_CurrentString.push_back(current);
 			if (current == '.' && usedDecimal) // need to throw some type of error again TODO
@@ -903,12 +1716,13 @@ namespace clear
 			current = _GetNextChar();
 		}
 
-		CLEAR_VERIFY(IsValidNumber(m_CurrentString),"Expected a valid number");
+		const NumberLiteral literal = DecodeNumberLiteral(m_CurrentString);
+		CLEAR_VERIFY(literal.Valid,"Expected a valid number");
 		if (m_CurrentString == "-") {
 			_PushToken(TokenType::SubOp,"-");
 		}else {
 
-			m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::RValueNumber, .Data = m_CurrentString });
+			_PushNumber(m_CurrentString, literal, start);
 		}
 		m_CurrentString.clear();
 		if (!IsSpace(current))
@@ -916,6 +1730,7 @@ namespace clear
 	}
 
 	void Parser::_ParseChar() {
+		const size_t start = m_CurrentTokenIndex;
 		char current = _GetNextChar();
 		char data = current;
 		if (current == '\\') {
@@ -950,7 +1765,7 @@ namespace clear
 		CLEAR_VERIFY(current!= '\'',"No data in char") // Allow this?
 
 
-		_PushToken(TokenType::RValueChar,Str(data));
+		_PushToken(TokenType::RValueChar,Str(data), start);
 		current = _GetNextChar();
 		CLEAR_VERIFY(current == '\'', "unclosed char: expected ' after char ");
 
@@ -960,10 +1775,30 @@ namespace clear
 
 	void Parser::_ParseString()
 	{
-		char current = _GetNextChar();
-		while (current != '"')
+		// strings without escapes are a slice of the buffer, the text is only copied once an escape is found
+		const size_t start = m_CurrentTokenIndex;
+		bool escaped = false;
+
+		while (true)
 		{
+			const size_t end = FindStringEnd(m_Buffer, m_CurrentTokenIndex);
+
+			if (escaped && end > m_CurrentTokenIndex)
+				m_CurrentString.append(m_Buffer.data() + m_CurrentTokenIndex, end - m_CurrentTokenIndex);
+
+			m_CurrentTokenIndex = end;
+
+			char current = _GetNextChar();
+			if (current == '"')
+				break;
+
 			CLEAR_VERIFY(!(current == '\n' || current == '\0'),"String never closed expected \"")
+
+			if (!escaped) {
+				m_CurrentString.assign(m_Buffer.substr(start, m_CurrentTokenIndex - 1 - start));
+				escaped = true;
+			}
+
 			if (current == '\\') {
 				current = _GetNextChar();
 				if (current == '"') {
@@ -991,12 +1826,13 @@ namespace clear
 				m_CurrentString += current;
 
 			}
-			current = _GetNextChar();
-
-
 		}
 
-		m_ProgramInfo.Tokens.push_back({ .TokenType = TokenType::RValueString, .Data = m_CurrentString });
+		if (escaped)
+			_PushToken(TokenType::RValueString, m_CurrentString, start);
+		else
+			_PushToken(TokenType::RValueString, m_Buffer.substr(start, m_CurrentTokenIndex - 1 - start));
+
 		m_CurrentString.clear();
 	}
 
@@ -1005,24 +1841,16 @@ namespace clear
 		char current = _GetNextChar();
 		m_CurrentString.clear();
 		
-		while (IsVarNameChar(current ) && current)
-		{
-			m_CurrentString += current;
-
-			current = _GetNextChar();
-			if (current == '\n' || current == '\0' || IsSpace(current))
-				break;
-		}
+		_ReadVarName(current);
 		if (current == '(') {
 			if (!m_CurrentString.empty())
 				_Backtrack();
 				return;
 		}
 
-		if (g_KeyWordMap.contains(m_CurrentString))
+		if (const ParserMapValue* value = g_KeyWordMap.Find(m_CurrentString))
 		{
-			auto& value = g_KeyWordMap.at(m_CurrentString);
-			m_ProgramInfo.Tokens.push_back({ .TokenType = value.TokenToPush, .Data = m_CurrentString });
+			_PushToken(value->TokenToPush, m_CurrentString);
 		}else {
 			_PushToken(TokenType::VariableReference, m_CurrentString);
 		}
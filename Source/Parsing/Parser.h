@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Tokens.h"
+#include "Core/Serialization.h"
+#include "Core/Utils.h"
 
 #include <vector>
 #include <string>
@@ -10,28 +12,116 @@
 #include <map>
 #include <functional>
 #include <queue>
+#include <memory>
+
+#include <llvm/Support/MemoryBuffer.h>
 
 namespace clear
 {
+	// a point the lexer can be restarted from, the start of a line outside any bracket, string or comment
+	struct LexerSyncPoint
+	{
+		uint32_t Offset = 0;
+		uint32_t Line = 1;
+		uint32_t Token = 0; // the first token lexed from here
+		uint32_t Indents = 0;
+	};
+
+	// a number token's payload is the NumberLiteral decoded by the lexer followed by its text, every other
+	// payload is only text
+	extern std::string_view GetPayloadText(const Token& token, std::string_view payload);
+	extern NumberLiteral GetPayloadLiteral(const Token& token, std::string_view payload);
+
 	struct ProgramInfo
 	{
 		std::vector<Token> Tokens;
+
+		std::shared_ptr<llvm::MemoryBuffer> Source; // kept alive for the tokens that slice it
+		std::string Payloads; // decoded data such as escaped strings and converted literals
+
+		std::vector<LexerSyncPoint> SyncPoints; // only recorded by incremental parsers
+
+		std::string_view GetData(const Token& token) const;
+		NumberLiteral GetLiteral(const Token& token) const; // only for RValueNumber tokens
+
+		// the source isn't written, a program is read back with the source it was cached for
+		void Serialize(BinaryWriter& writer) const;
+		static ProgramInfo Deserialize(BinaryReader& reader, std::shared_ptr<llvm::MemoryBuffer> source);
 	};
 
-	class Parser
+	// replaces [Start, End) of the previous source with Text
+	struct TextEdit
 	{
-	public:
-		using StateMapType    = std::map<ParserState, std::function<void()>>;
+		size_t Start = 0;
+		size_t End = 0;
+		std::string Text;
+	};
+
+	// the tokens an incremental update relexed, [First, OldEnd) of the previous tokens became [First, NewEnd)
+	struct TokenEdit
+	{
+		size_t First = 0;
+		size_t OldEnd = 0;
+		size_t NewEnd = 0;
+	};
+
+	// the lexing state of an enclosing region, saved while a nested region of the same buffer is lexed in place
+	struct LexerRegion
+	{
+		std::string_view Buffer;
+		size_t TokenIndex = 0;
+		size_t TokenBase = 0;
+		char Sentinel = '\n';
+
+		ParserState State = ParserState::Default;
+		size_t Indents = 0;
+		size_t IndentLevel = 0;
+		size_t IndentationLevel = 0;
+		bool LineStarted = false;
+
+		std::string CurrentString;
+		std::vector<char> BracketStack;
+	};
+
+	// a piece of a large file that is lexed on its own thread, it starts and ends at a line break outside any
+	// bracket, string or comment so the lexer is in the same state there as it would be lexing the whole file
+	struct LexerChunk
+	{
+		size_t Start = 0;
+		size_t End = 0;
+		size_t Line = 1;
+
+		ProgramInfo Info;
+		size_t FirstIndents = 0; // indentation of the first line, its tokens depend on the previous chunk
+		size_t FinalIndents = 0;
+		bool Valid = false;      // false when the lexer didn't end the chunk where expected, the file is lexed serially then
+	};
+
+	class TokenStream;
 
+	class Parser
+	{
 	public:
-		Parser();
+		Parser() = default;
 		~Parser() = default;
 
-		ProgramInfo CreateTokensFromFile(const std::filesystem::path& path);
+		// files of at least two chunks are split and lexed on up to threads threads, 0 uses one per hardware thread
+		ProgramInfo CreateTokensFromFile(const std::filesystem::path& path, uint32_t threads = 1);
+		ProgramInfo CreateTokensFromBuffer(std::shared_ptr<llvm::MemoryBuffer> source, uint32_t threads = 1);
+		// lexes on the calling thread, tokens are pushed to the stream in batches instead of being kept
+		void StreamTokensFromFile(const std::filesystem::path& path, TokenStream& stream);
 		void InitParser();
 		ProgramInfo ParseProgram();
 
+		// records the sync points UpdateTokens restarts from, files are always lexed serially then
+		void SetIncremental(bool incremental) { m_Incremental = incremental; }
+
+		// applies the edit to the source of info and relexes from the last sync point before it, until the lexer
+		// reaches a sync point it also had before the edit. the tokens after that are shifted rather than relexed
+		TokenEdit UpdateTokens(ProgramInfo& info, const TextEdit& edit);
+
 	private:
+		void _RunState();
 		void _DefaultState();
 		void _VariableNameState();
 		void _OperatorState();
@@ -54,20 +144,37 @@ namespace clear
 		void _ParseString();
 		void _ParseOther();
 		void _ParseChar();
-		void _ParseBinaryLiteral();
-		void _ParseHexLiteral();
+		void _ParseBinaryLiteral(size_t start);
+		void _ParseHexLiteral(size_t start);
 
 		void _ParseArrayDecleration();
 		void _ParsePointerDecleration();
 
-		void _PushToken(const TokenType tok, const std::string& data);
+		// start is the index in the buffer the token began at, it only has to be given for literals that get decoded
+		void _PushToken(const TokenType tok, std::string_view data = {}, size_t start = std::string_view::npos);
+		void _PushNumber(std::string_view text, const NumberLiteral& literal, size_t start = std::string_view::npos);
+		void _SetLocation(Token& token, size_t offset);
+		void _LexRegion(std::string_view buffer);
+		void _PushRegion(std::string_view buffer);
+		void _PopRegion();
+
+		std::string_view _SliceBuffer(size_t start, const std::string& text);
 		bool _IsLineClosed();
 		char _SkipSpaces();
+		void _ReadVarName(char& current);
 
 		char _GetNextChar();
+		size_t _GetBufferLength() const { return m_Buffer.length() + 1; }
 		void _Backtrack();
 		void _EndLine();
 
+		bool _ParseProgramParallel(uint32_t threads);
+		std::vector<LexerChunk> _SplitSource(size_t chunkCount);
+		void _LexChunk(std::string_view source, LexerChunk& chunk, bool first, bool last);
+		void _FlushTokens(size_t keep);
+		bool _AtSyncPoint() const;
+		void _RecordSyncPoint();
+
 
 	private:
 		size_t m_CurrentTokenIndex = 0;
@@ -75,14 +182,33 @@ namespace clear
 		size_t m_CurrentIndentationLevel = 0;
 		size_t m_Indents = 0;
 		bool m_LineStarted = false;
-		std::ifstream m_File;
 		ProgramInfo m_ProgramInfo;
 
-		StateMapType m_StateMap;
-
 		ParserState m_CurrentState = ParserState::Default;
 
-		std::string m_Buffer;
+		// the source is mapped rather than copied, m_Buffer views it (or a nested region such as a call argument)
+		// and m_Sentinel is read one past its end instead of appending a character to the buffer
+		std::string_view m_Source; // the whole file
+		std::string_view m_Buffer;
+		char m_Sentinel = '\n';
+
+		// enclosing regions, m_TokenBase is the first token of the current one
+		std::vector<LexerRegion> m_RegionStack;
+		size_t m_TokenBase = 0;
+
+		// a chunk doesn't know the indentation it starts at, its first indentation pushes a placeholder token instead
+		bool m_IndentsUnknown = false;
+		size_t m_FirstIndents = 0;
+		bool m_ReadSentinel = false;
+
+		TokenStream* m_Stream = nullptr;
+		bool m_Incremental = false;
+
+		// line numbers are found by moving a cursor over the source rather than counting from the start each time
+		size_t m_CursorOffset = 0;
+		size_t m_CursorLine = 1;
+		size_t m_CursorLineStart = 0;
+
 		std::string m_CurrentString;
 		std::vector<char> m_BracketStack;
 
@@ -0,0 +1,176 @@
+#include "TokenStream.h"
+#include "Parser.h"
+
+#include <Core/Log.h>
+#include <Core/Profiler.h>
+
+#include <algorithm>
+
+namespace clear
+{
+	TokenStream::TokenStream(const std::filesystem::path& path, size_t window)
+	{
+		size_t capacity = 16;
+
+		while (capacity < window)
+			capacity *= 2;
+
+		m_Slots.resize(capacity);
+		m_Mask = capacity - 1;
+
+		m_Lexer = std::thread([this, path]()
+			{
+				Parser parser;
+				parser.StreamTokensFromFile(path, *this);
+			});
+	}
+
+	TokenStream::~TokenStream()
+	{
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Abandoned = true;
+		}
+
+		m_SpaceAvailable.notify_all();
+		m_Lexer.join();
+	}
+
+	Token TokenStream::operator[](size_t index)
+	{
+		CLEAR_VERIFY(index >= m_Released, "token ", index, " was read after it was released");
+
+		if (index < m_Count.load(std::memory_order_acquire) || _WaitFor(index))
+			return m_Slots[index & m_Mask].Value;
+
+		return Token{};
+	}
+
+	bool TokenStream::Contains(size_t index)
+	{
+		return index < m_Count.load(std::memory_order_acquire) || _WaitFor(index);
+	}
+
+	void TokenStream::Release(size_t index)
+	{
+		m_ReleaseRequested = std::max(m_ReleaseRequested, index);
+
+		// taking the lock for every token would cost more than the lexer saves, slots are handed back in batches
+		if (m_ReleaseRequested < m_Released + (m_Slots.size() / 4))
+			return;
+
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Released = std::min(m_ReleaseRequested, m_Count.load(std::memory_order_relaxed));
+		}
+
+		m_SpaceAvailable.notify_one();
+	}
+
+	std::string_view TokenStream::GetData(const Token& token) const
+	{
+		switch (token.Flags)
+		{
+			case TokenFlags::Source:  return std::string_view(m_Source->getBufferStart() + token.Offset, token.Length);
+			case TokenFlags::Payload: return GetPayloadText(token, m_Slots[token.Offset & m_Mask].Payload);
+			case TokenFlags::None:
+			default:
+				break;
+		}
+
+		return {};
+	}
+
+	NumberLiteral TokenStream::GetLiteral(const Token& token) const
+	{
+		CLEAR_VERIFY(token.Flags == TokenFlags::Payload, "token is not a decoded number");
+		return GetPayloadLiteral(token, m_Slots[token.Offset & m_Mask].Payload);
+	}
+
+	void TokenStream::SetSource(std::shared_ptr<llvm::MemoryBuffer> source)
+	{
+		std::lock_guard lock(m_Mutex);
+		m_Source = std::move(source);
+	}
+
+	void TokenStream::Push(const Token* tokens, size_t count, std::string_view payloads)
+	{
+		CLEAR_PROFILE_SCOPE("TokenStream::Push");
+
+		std::unique_lock lock(m_Mutex);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const size_t index = m_Count.load(std::memory_order_relaxed);
+
+			if (index - m_Released >= m_Slots.size())
+			{
+				m_TokensAvailable.notify_one();
+				m_SpaceAvailable.wait(lock, [&]() { return index - m_Released < m_Slots.size() || m_Abandoned; });
+			}
+
+			if (m_Abandoned)
+				return;
+
+			Slot& slot = m_Slots[index & m_Mask];
+			slot.Value = tokens[i];
+
+			if (slot.Value.Flags == TokenFlags::Payload)
+			{
+				slot.Payload = payloads.substr(slot.Value.Offset, slot.Value.Length);
+				slot.Value.Offset = (uint32_t)index;
+			}
+
+			m_Count.store(index + 1, std::memory_order_release);
+		}
+
+		lock.unlock();
+		m_TokensAvailable.notify_one();
+	}
+
+	void TokenStream::Close()
+	{
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Closed = true;
+		}
+
+		m_TokensAvailable.notify_one();
+	}
+
+	bool TokenStream::_WaitFor(size_t index)
+	{
+		CLEAR_PROFILE_SCOPE("TokenStream::Wait");
+
+		std::unique_lock lock(m_Mutex);
+
+		while (index >= m_Count.load(std::memory_order_relaxed) && !m_Closed)
+		{
+			// hand back what is still held from the last batch before deciding the window is too small
+			m_Released = std::max(m_Released, std::min(m_ReleaseRequested, m_Count.load(std::memory_order_relaxed)));
+
+			// the consumer needs more tokens than the window holds, waiting for the lexer would never end
+			if (index - m_Released >= m_Slots.size())
+				_Grow();
+
+			m_SpaceAvailable.notify_one();
+
+			m_TokensAvailable.wait(lock);
+		}
+
+		return index < m_Count.load(std::memory_order_relaxed);
+	}
+
+	void TokenStream::_Grow()
+	{
+		std::vector<Slot> slots(m_Slots.size() * 2);
+		const size_t mask = slots.size() - 1;
+
+		for (size_t i = m_Released; i < m_Count.load(std::memory_order_relaxed); i++)
+			slots[i & mask] = std::move(m_Slots[i & m_Mask]);
+
+		m_Slots = std::move(slots);
+		m_Mask = mask;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Tokens.h"
+#include "Core/Utils.h"
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+#include <llvm/Support/MemoryBuffer.h>
+
+namespace clear
+{
+	// tokens of a file handed from a lexer thread to the consumer as they are produced. only a window of tokens is
+	// held at once, the lexer waits when the consumer falls behind. the window grows if the consumer looks further
+	// ahead than it allows so a long construct can't stall both sides
+	class TokenStream
+	{
+	public:
+		TokenStream(const std::filesystem::path& path, size_t window = 4096);
+		~TokenStream();
+
+		TokenStream(const TokenStream&) = delete;
+		TokenStream& operator=(const TokenStream&) = delete;
+
+		// waits for the token, tokens past the end of the file read as TokenType::None
+		Token operator[](size_t index);
+
+		// waits until the token is lexed or the file has ended
+		bool Contains(size_t index);
+
+		// tokens before index are no longer read and their slots can be reused
+		void Release(size_t index);
+
+		std::string_view GetData(const Token& token) const;
+		NumberLiteral GetLiteral(const Token& token) const;
+
+		// called by the lexer thread, payload tokens are sliced from payloads
+		void SetSource(std::shared_ptr<llvm::MemoryBuffer> source);
+		void Push(const Token* tokens, size_t count, std::string_view payloads);
+		void Close();
+
+	private:
+		struct Slot
+		{
+			Token Value;
+			std::string Payload; // payload tokens point at their slot rather than a shared arena
+		};
+
+		bool _WaitFor(size_t index);
+		void _Grow();
+
+	private:
+		std::shared_ptr<llvm::MemoryBuffer> m_Source;
+
+		std::vector<Slot> m_Slots;
+		size_t m_Mask = 0;
+
+		std::atomic<size_t> m_Count = 0; // tokens pushed so far
+		size_t m_Released = 0;
+		size_t m_ReleaseRequested = 0; // only touched by the consumer, applied to m_Released in batches
+		bool m_Closed = false;
+		bool m_Abandoned = false; // the consumer is gone, the lexer drops what it pushes
+
+		std::mutex m_Mutex;
+		std::condition_variable m_TokensAvailable;
+		std::condition_variable m_SpaceAvailable;
+
+		std::thread m_Lexer;
+	};
+
+}
\ No newline at end of file
@@ -1,10 +1,9 @@
 #include "Tokens.h"
 
 #include <string_view>
-#include <set>
 
 namespace clear {
-    const OperatorMapType g_OperatorMap = {
+    constexpr OperatorMapType g_OperatorMap = std::array<OperatorMapType::Entry, 20>{{
         {"=", {.NextState = ParserState::RValue, .TokenToPush = TokenType::Assignment}},
         {"*", {.NextState = ParserState::AsterisksOperator, .TokenToPush = TokenType::None}},
         {"/", {.NextState = ParserState::RValue, .TokenToPush = TokenType::DivOp}},
@@ -25,9 +24,9 @@ namespace clear {
         {"/*",{.NextState = ParserState::MultilineComment, .TokenToPush = TokenType::None}},
         {",",{.NextState = ParserState::Default, .TokenToPush = TokenType::Comma}},
         {"&",{.NextState = ParserState::RValue, .TokenToPush = TokenType::AddressOp}},
-    };
+    }};
 
-    const KeyWordMapType g_KeyWordMap = {
+    constexpr KeyWordMapType g_KeyWordMap = std::array<KeyWordMapType::Entry, 23>{{
         {"int8", {.NextState = ParserState::VariableName, .TokenToPush = TokenType::Int8Type}},
         {"int16", {.NextState = ParserState::VariableName, .TokenToPush = TokenType::Int16Type}},
         {"int32", {.NextState = ParserState::VariableName, .TokenToPush = TokenType::Int32Type}},
@@ -51,11 +50,33 @@ namespace clear {
         {"return", {.NextState = ParserState::RValue, .TokenToPush = TokenType::Return}},
         {"char",{.NextState = ParserState::VariableName, .TokenToPush = TokenType::CharType}},
         {"declare", {.NextState = ParserState::Default, .TokenToPush = TokenType::Declaration}},
-    };
+    }};
 
-    const std::set<std::string> g_DataTypes = {
-        "float64", "float32", "bool", "string", "uint64", "uint32", "uint16", "uint8", "int64", "int32", "int16", "int8","int","uint","char"
-    };
+    constexpr DataTypeSetType g_DataTypes = std::array<DataTypeSetType::Entry, 15>{{
+        {"float64", TokenType::Float64Type}, {"float32", TokenType::Float32Type}, {"bool", TokenType::Bool}, {"string", TokenType::StringType},
+        {"uint64", TokenType::UInt64Type}, {"uint32", TokenType::UInt32Type}, {"uint16", TokenType::UInt16Type}, {"uint8", TokenType::UInt8Type},
+        {"int64", TokenType::Int64Type}, {"int32", TokenType::Int32Type}, {"int16", TokenType::Int16Type}, {"int8", TokenType::Int8Type},
+        {"int", TokenType::Int32Type}, {"uint", TokenType::UInt32Type}, {"char", TokenType::CharType}
+    }};
+
+    constexpr std::array<bool, 256> g_OperatorCharacters = []()
+        {
+            std::array<bool, 256> characters{};
+
+            for (const auto& entry : g_OperatorMap.GetEntries())
+            {
+                if (entry.Key.size() == 1)
+                    characters[uint8_t(entry.Key[0])] = true;
+            }
+
+            for (const auto& entry : g_OperatorMap.GetEntries())
+            {
+                if (!characters[uint8_t(entry.Key[0])])
+                    throw "every operator has to start with a single character operator";
+            }
+
+            return characters;
+        }();
 
     std::string_view TokenToString(TokenType token) {
         switch (token) 
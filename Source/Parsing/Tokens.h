@@ -2,13 +2,13 @@
 
 #include <string_view>
 #include <string>
-#include <map>
-#include <set>
+#include <cstdint>
+#include <array>
 
 
 namespace clear {
 
-    enum class TokenType
+    enum class TokenType : uint8_t
     {
         None = 0, Int8Type, Int16Type, Int32Type, Int64Type, UInt8Type, UInt16Type, UInt32Type, UInt64Type,
         Bool, Float32Type, Float64Type, RValueNumber, RValueString, VariableName, StringType,
@@ -45,18 +45,112 @@ namespace clear {
     };
 
 
+    // what a token's offset and length refer to, see ProgramInfo::GetData
+    enum class TokenFlags : uint8_t
+    {
+        None = 0, // no data
+        Source,   // a slice of the source buffer
+        Payload   // a slice of the payload arena, for data that doesn't appear in the source as is
+    };
+
     struct Token
     {
         TokenType TokenType = TokenType::None;
-        std::string Data = "";
+        TokenFlags Flags = TokenFlags::None;
+        uint16_t Column = 0; // 1 based, columns past 65535 are reported as 65535 so the token stays 16 bytes
+        uint32_t Line = 0;
+        uint32_t Offset = 0;
+        uint32_t Length = 0;
     };
 
+    static_assert(sizeof(Token) == 16, "tokens are kept small so the token vector stays cache friendly");
+
     std::string_view TokenToString(TokenType token);
 
-    using OperatorMapType = std::map<std::string, ParserMapValue>;
-    using KeyWordMapType  = std::map<std::string, ParserMapValue>;
+    // a fixed set of keys known at compile time, looked up by string_view without allocating. the constructor
+    // searches for a hash seed that gives every key its own slot, so a lookup is one hash and one compare
+    template<typename T, size_t N, size_t Slots = 64>
+    class StaticStringMap
+    {
+    public:
+        static_assert((Slots & (Slots - 1)) == 0 && Slots > N, "slots must be a power of two larger than the key count");
+
+        struct Entry
+        {
+            std::string_view Key;
+            T Value;
+        };
+
+        constexpr StaticStringMap(const std::array<Entry, N>& entries)
+            : m_Entries(entries)
+        {
+            for (m_Seed = 1; m_Seed < 100000; m_Seed++)
+            {
+                if (_TryFill())
+                    return;
+            }
+
+            throw "no perfect hash seed found, increase the slot count";
+        }
+
+        constexpr const T* Find(std::string_view key) const
+        {
+            const uint8_t slot = m_Slots[Hash(key, m_Seed) & (Slots - 1)];
+
+            if (slot == 0 || m_Entries[slot - 1].Key != key)
+                return nullptr;
+
+            return &m_Entries[slot - 1].Value;
+        }
+
+        constexpr bool Contains(std::string_view key) const { return Find(key) != nullptr; }
+
+        constexpr const std::array<Entry, N>& GetEntries() const { return m_Entries; }
+
+        static constexpr uint32_t Hash(std::string_view key, uint32_t seed)
+        {
+            uint32_t hash = 2166136261u ^ seed;
+
+            for (char c : key)
+                hash = (hash ^ uint8_t(c)) * 16777619u;
+
+            return hash ^ (hash >> 15);
+        }
+
+    private:
+        constexpr bool _TryFill()
+        {
+            m_Slots = {};
+
+            for (size_t i = 0; i < N; i++)
+            {
+                uint8_t& slot = m_Slots[Hash(m_Entries[i].Key, m_Seed) & (Slots - 1)];
+
+                if (slot != 0)
+                    return false;
+
+                slot = uint8_t(i + 1);
+            }
+
+            return true;
+        }
+
+    private:
+        std::array<Entry, N> m_Entries;
+        std::array<uint8_t, Slots> m_Slots{}; // index + 1 into m_Entries, 0 is empty
+        uint32_t m_Seed = 0;
+    };
+
+    using OperatorMapType = StaticStringMap<ParserMapValue, 20>;
+    using KeyWordMapType  = StaticStringMap<ParserMapValue, 23>;
+    using DataTypeSetType = StaticStringMap<TokenType, 15>;
 
     extern const OperatorMapType g_OperatorMap;
     extern const KeyWordMapType  g_KeyWordMap;
-    extern const std::set<std::string> g_DataTypes;
+    extern const DataTypeSetType g_DataTypes;
+
+    // characters that are an operator on their own, every longer operator starts with one of them
+    extern const std::array<bool, 256> g_OperatorCharacters;
+
+    inline bool IsOperatorChar(char c) { return g_OperatorCharacters[uint8_t(c)]; }
 }
\ No newline at end of file
@@ -1,43 +1,309 @@
 ﻿#include "Parsing/Parser.h"
+#include "Parsing/TokenStream.h"
 #include "AST/AST.h"
+#include "AST/FlatAST.h"
 #include "Core/Log.h"
+#include "Core/Profiler.h"
+#include "Core/CompileCache.h"
 
 #include "API/LLVM/LLVMBackend.h"
 
 #include <iostream>
 #include <filesystem>
+#include <algorithm>
 
 using namespace clear;
 
-int main()
+static llvm::cl::list<std::string> s_Inputs(llvm::cl::Positional, llvm::cl::desc("[run] <input files>"));
+
+static llvm::cl::opt<std::string> s_OutputPath("o", llvm::cl::desc("Output object file, with several inputs an archive of the same name is written (default = 'Tests/output.o')"),
+                                              llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<uint32_t> s_Threads("j", llvm::cl::desc("Threads used for parallel code generation (default = one per hardware thread)"),
+                                        llvm::cl::Prefix, llvm::cl::init(0));
+
+static llvm::cl::opt<uint32_t> s_LexThreads("lex-threads", llvm::cl::desc("Threads used to lex large files in parallel chunks, 0 = one per hardware thread (default = 1)"),
+                                           llvm::cl::value_desc("N"), llvm::cl::init(1));
+
+static llvm::cl::opt<uint32_t> s_SplitCount("split-module", llvm::cl::desc("Split a single module into N parts that are code generated in parallel, "
+                                                                           "the parts are archived into the output with a .a extension (default = 1)"),
+                                           llvm::cl::value_desc("N"), llvm::cl::init(1));
+
+static llvm::cl::opt<char> s_OptimizationLevel("O", llvm::cl::desc("Optimization level. [-O0, -O1, -O2, -O3, -Os or -Oz] (default = '-O0')"),
+                                               llvm::cl::Prefix, llvm::cl::init('0'));
+
+static llvm::cl::opt<bool> s_PrintPipeline("print-pipeline", llvm::cl::desc("Print the optimization pipeline that is run on the module"),
+                                           llvm::cl::init(false));
+
+static llvm::cl::opt<std::string> s_TargetTriple("target", llvm::cl::desc("Target triple to generate code for (default = host triple)"),
+                                                llvm::cl::value_desc("triple"));
+
+static llvm::cl::opt<std::string> s_CPU("mcpu", llvm::cl::desc("Target cpu to tune for, 'native' detects the host cpu and its features (default = 'generic')"),
+                                       llvm::cl::value_desc("cpu-name"), llvm::cl::init("generic"));
+
+static llvm::cl::opt<std::string> s_Features("mattr", llvm::cl::desc("Target specific attributes, e.g -mattr=+avx2,-sse4.1"),
+                                            llvm::cl::value_desc("a1,+a2,-a3,..."));
+
+static llvm::cl::opt<bool> s_TimeReport("time-report", llvm::cl::desc("Print a table of the time spent in every compilation phase and optimization pass"),
+                                        llvm::cl::init(false));
+
+static llvm::cl::opt<bool> s_TimeTrace("time-trace", llvm::cl::desc("Write a chrome trace event file of the compilation, loadable in chrome://tracing or perfetto"),
+                                       llvm::cl::init(false));
+
+static llvm::cl::opt<std::string> s_TimeTraceFile("time-trace-file", llvm::cl::desc("Trace file written by --time-trace (default = output path with a .json extension)"),
+                                                  llvm::cl::value_desc("filename"));
+
+static llvm::cl::opt<bool> s_TimeTraceFunctions("time-trace-functions", llvm::cl::desc("Also profile the code generation of every function"),
+                                                llvm::cl::init(false));
+
+static llvm::cl::opt<std::string> s_CacheDirectory("cache-dir", llvm::cl::desc("Reuse the tokens and ast of inputs compiled before, stored in this directory by a hash of their source"),
+                                                   llvm::cl::value_desc("directory"));
+
+static llvm::cl::opt<uint32_t> s_CacheSize("cache-size", llvm::cl::desc("Size in megabytes the cache directory is kept under, the least recently used entries are removed first (default = 512)"),
+                                          llvm::cl::value_desc("MB"), llvm::cl::init(512));
+
+static llvm::cl::opt<bool> s_CacheStats("cache-stats", llvm::cl::desc("Print the cache hits, misses and evictions of this compilation"),
+                                        llvm::cl::init(false));
+
+static llvm::cl::opt<bool> s_FlatAST("flat-ast", llvm::cl::desc("Generate code from the flat array form of the ast, inputs that are streamed or cached still use the tree"),
+                                     llvm::cl::init(false));
+
+// an input whose tokens and ast were found in the cache, the ast is read when its module is generated
+struct CachedInput
 {
+    uint64_t Key = 0;
+    std::unique_ptr<llvm::MemoryBuffer> Entry;
+    size_t ASTOffset = 0;
+};
+
+static void FinishProfiling(const std::filesystem::path& tracePath)
+{
+    if (!Profiler::IsEnabled())
+        return;
+
+    Profiler::EndSession();
+
+    if (s_TimeTrace)
+        Profiler::WriteChromeTrace(tracePath);
+
+    if (s_TimeReport)
+        Profiler::PrintSummary();
+}
+
+int main(int argc, char** argv)
+{
+    llvm::cl::ParseCommandLineOptions(argc, argv, "clear compiler\n");
+
+    LLVM::BuildOptions buildOptions;
+    buildOptions.OptLevel = LLVM::OptimizationLevelFromChar(s_OptimizationLevel);
+    buildOptions.PrintPipeline = s_PrintPipeline;
+    buildOptions.TargetTriple = s_TargetTriple;
+    buildOptions.CPU = s_CPU;
+    buildOptions.Features = s_Features;
+
+    // "clear run file.cl" jit compiles and runs the program instead of writing an object file
+    const bool runMode = !s_Inputs.empty() && s_Inputs.front() == "run";
+
+    if (runMode)
+        s_Inputs.erase(s_Inputs.begin());
+
+    std::vector<std::filesystem::path> inputs;
+
+    for (const auto& input : s_Inputs)
+        inputs.push_back(std::filesystem::absolute(input.c_str()));
+
+    if (inputs.empty())
+        inputs.push_back("Tests/test.cl");
+
+    if (!s_OutputPath.empty())
+        buildOptions.OutputPath = std::filesystem::absolute(s_OutputPath.c_str());
+
+    std::filesystem::path cacheDirectory;
+
+    if (!s_CacheDirectory.empty())
+        cacheDirectory = std::filesystem::absolute(s_CacheDirectory.c_str());
+
+    // the trace is written next to the output unless a file is given
+    std::filesystem::path tracePath = buildOptions.OutputPath;
+    tracePath.replace_extension(".json");
+
+    if (!s_TimeTraceFile.empty())
+        tracePath = std::filesystem::absolute(s_TimeTraceFile.c_str());
+
+    buildOptions.Threads = s_Threads;
+    buildOptions.SplitCount = s_SplitCount;
+
+    if (s_TimeReport || s_TimeTrace)
+        Profiler::BeginSession(s_TimeTraceFunctions);
+
     std::filesystem::path current = __FILE__;
     std::filesystem::current_path(current.parent_path());
 
     LLVM::Backend::Init();
 
-    std::cout << "------PARSER TESTS--------" << std::endl;
-    Parser parser;
-    ProgramInfo info = parser.CreateTokensFromFile("Tests/test.cl");
+    std::unique_ptr<CompileCache> cache;
 
-    for (size_t i = 0; i < info.Tokens.size(); i++)
+    if (!cacheDirectory.empty())
+        cache = std::make_unique<CompileCache>(cacheDirectory, uint64_t(s_CacheSize) << 20);
+
+    // run mode doesn't print the tokens, so each file is lexed on another thread while its ast is built.
+    // a cached file isn't lexed at all, the whole source is needed up front to look it up
+    const bool streamTokens = runMode && s_LexThreads == 1 && !cache;
+
+    // every input file gets its own module, only the first one owns main
+    std::vector<ProgramInfo> programs;
+    std::vector<std::string> moduleNames;
+    std::vector<CachedInput> cachedInputs(inputs.size());
+
+    auto getRootName = [&](size_t i) { return i == 0 ? std::string("main") : moduleNames[i] + "::main"; };
+
+    for (size_t i = 0; i < inputs.size(); i++)
     {
-        std::cout << "Token Type: " << TokenToString(info.Tokens[i].TokenType);
-        std::cout << ", Data: " << info.Tokens[i].Data;
-        std::cout << std::endl;
+        std::string name = inputs[i].stem().string();
+
+        if (std::find(moduleNames.begin(), moduleNames.end(), name) != moduleNames.end())
+            name += std::to_string(i);
+
+        moduleNames.push_back(name);
+
+        if (streamTokens)
+            continue;
+
+        std::shared_ptr<llvm::MemoryBuffer> source;
+
+        if (cache)
+        {
+            if (auto file = llvm::MemoryBuffer::getFile(inputs[i].string(), /*IsText=*/false, /*RequiresNullTerminator=*/false))
+                source = std::move(*file);
+        }
+
+        if (!source)
+        {
+            Parser parser;
+            programs.push_back(parser.CreateTokensFromFile(inputs[i], s_LexThreads));
+            continue;
+        }
+
+        // names in the ast are prefixed with the root name, so it is part of the key
+        CachedInput& cached = cachedInputs[i];
+        cached.Key = CompileCache::GetKey(source->getBuffer(), getRootName(i));
+        cached.Entry = cache->Load(cached.Key);
+
+        if (cached.Entry)
+        {
+            BinaryReader reader(CompileCache::GetData(*cached.Entry));
+            programs.push_back(ProgramInfo::Deserialize(reader, source));
+            cached.ASTOffset = reader.GetOffset();
+            continue;
+        }
+
+        Parser parser;
+        programs.push_back(parser.CreateTokensFromBuffer(source, s_LexThreads));
     }
 
-    std::cout << "------AST TESTS--------" << std::endl;
+    if (inputs.size() > 1)
     {
-        AST ast(info);
-        ast.BuildIR("Tests/test.ir");
+        LLVM::Backend::GetModule()->setModuleIdentifier(moduleNames[0]);
+
+        for (size_t i = 1; i < inputs.size(); i++)
+            LLVM::Backend::CreateModule(moduleNames[i]);
     }
 
+    auto generateModule = [&](size_t i, const std::filesystem::path& irPath)
+        {
+            LLVM::Backend::SetCurrentModule(i);
+
+            const std::string rootName = getRootName(i);
+            const CachedInput& cached = cachedInputs[i];
+
+            if (streamTokens)
+            {
+                TokenStream stream(inputs[i]);
+
+                AST ast(stream, rootName);
+                ast.BuildIR(irPath);
+                return;
+            }
+
+            if (cached.Entry)
+            {
+                BinaryReader reader(CompileCache::GetData(*cached.Entry).substr(cached.ASTOffset));
+
+                AST ast(reader, rootName);
+                ast.BuildIR(irPath);
+                return;
+            }
+
+            // only the tree is written to the cache
+            if (s_FlatAST && !cached.Key)
+            {
+                FlatAST ast(programs[i], rootName);
+                ast.BuildIR(irPath);
+                return;
+            }
 
+            AST ast(programs[i], rootName);
 
-    LLVM::Backend::BuildModule();
+            // codegen doesn't change the ast, it is stored before the module is generated
+            if (cached.Key)
+            {
+                std::string data;
+                BinaryWriter writer(data);
+
+                programs[i].Serialize(writer);
+                ast.Serialize(writer);
+
+                cache->Store(cached.Key, data);
+            }
+
+            ast.BuildIR(irPath);
+        };
+
+    auto finishCache = [&]()
+        {
+            if (cache && s_CacheStats)
+                cache->PrintStats();
+        };
+
+    if (runMode)
+    {
+        for (size_t i = 0; i < inputs.size(); i++)
+            generateModule(i, {});
+
+        int result = LLVM::Backend::RunModule(buildOptions);
+
+        LLVM::Backend::Shutdown();
+        FinishProfiling(tracePath);
+        finishCache();
+
+        return result;
+    }
+
+    std::cout << "------PARSER TESTS--------" << std::endl;
+
+    for (const auto& info : programs)
+    {
+        for (size_t i = 0; i < info.Tokens.size(); i++)
+        {
+            std::cout << "Token Type: " << TokenToString(info.Tokens[i].TokenType);
+            std::cout << ", Data: " << info.GetData(info.Tokens[i]);
+            std::cout << std::endl;
+        }
+    }
+
+    std::cout << "------AST TESTS--------" << std::endl;
+
+    for (size_t i = 0; i < programs.size(); i++)
+        generateModule(i, programs.size() == 1 ? "Tests/test.ir" : "Tests/" + moduleNames[i] + ".ir");
+
+    if (programs.size() == 1)
+        LLVM::Backend::BuildModule(buildOptions);
+    else
+        LLVM::Backend::BuildModules(buildOptions);
 
     LLVM::Backend::Shutdown();
+    FinishProfiling(tracePath);
+    finishCache();
 
     return 0;
-}
+}
\ No newline at end of file